@@ -0,0 +1,241 @@
+// Times the block accesses of the light rebuild, of the chunk snapshots taken for visibility
+// updates and of plain neighbour reads with both block layouts of VSBasicChunkSections. Build
+// with -DVS_BUILD_BENCHMARKS=ON.
+//
+// Only the storage inside the sections changes with the layout. Like the engine, every pass
+// addresses blocks by linear chunk index, so the numbers include translating those indices and
+// do not show what a tiled traversal of the callers would gain.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "world/vs_chunk_sections.h"
+
+namespace
+{
+constexpr auto chunkSize = glm::ivec3(32, 64, 32);
+constexpr std::size_t chunkBlockCount = chunkSize.x * chunkSize.y * chunkSize.z;
+constexpr int repetitionCount = 50;
+
+std::size_t getBlockIndex(int x, int y, int z)
+{
+    return x + y * chunkSize.x + z * chunkSize.x * chunkSize.y;
+}
+
+// stone below a rolling surface, grass on top and a few ores, the rest is air
+std::vector<VSBlockID> createTerrain()
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> ore(0, 40);
+    std::vector<VSBlockID> blocks(chunkBlockCount, 0);
+    for (int z = 0; z < chunkSize.z; z++)
+    {
+        for (int x = 0; x < chunkSize.x; x++)
+        {
+            const int height = 24 + (x * 7 + z * 13) % 16;
+            for (int y = 0; y < height; y++)
+            {
+                const VSBlockID blockID = y + 1 == height ? 3 : (ore(gen) == 0 ? 7 : 1);
+                blocks[getBlockIndex(x, y, z)] = blockID;
+            }
+        }
+    }
+    return blocks;
+}
+
+// same passes as VSChunkManager::rebuildLight for one chunk, sky light only
+template <typename BlockLayout>
+void rebuildLight(VSBasicChunkSections<BlockLayout>& sections)
+{
+    constexpr std::uint8_t maxLight = 15;
+    std::queue<std::size_t> addQueue;
+    for (int z = 0; z < chunkSize.z; z++)
+    {
+        for (int x = 0; x < chunkSize.x; x++)
+        {
+            bool bIsOpenToSky = true;
+            for (int y = chunkSize.y - 1; y >= 0; y--)
+            {
+                const auto blockIndex = getBlockIndex(x, y, z);
+                bIsOpenToSky = bIsOpenToSky && sections.getBlock(blockIndex) == 0;
+                sections.setLight(blockIndex, bIsOpenToSky ? maxLight : 0);
+                if (bIsOpenToSky)
+                {
+                    addQueue.push(blockIndex);
+                }
+            }
+        }
+    }
+
+    const std::size_t strides[] = {
+        getBlockIndex(1, 0, 0), getBlockIndex(0, 1, 0), getBlockIndex(0, 0, 1)};
+    while (!addQueue.empty())
+    {
+        const auto blockIndex = addQueue.front();
+        addQueue.pop();
+        const auto light = sections.getLight(blockIndex);
+        if (light <= 1)
+        {
+            continue;
+        }
+
+        const auto coordinates = glm::ivec3(
+            blockIndex % chunkSize.x,
+            blockIndex / chunkSize.x % chunkSize.y,
+            blockIndex / (chunkSize.x * chunkSize.y));
+        const int axisCoordinates[] = {coordinates.x, coordinates.y, coordinates.z};
+        const int axisSizes[] = {chunkSize.x, chunkSize.y, chunkSize.z};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (const int direction : {-1, 1})
+            {
+                const auto neighbourCoordinate = axisCoordinates[axis] + direction;
+                if (neighbourCoordinate < 0 || neighbourCoordinate >= axisSizes[axis])
+                {
+                    continue;
+                }
+
+                const auto neighbourIndex =
+                    direction < 0 ? blockIndex - strides[axis] : blockIndex + strides[axis];
+                if (sections.getBlock(neighbourIndex) == 0 &&
+                    sections.getLight(neighbourIndex) < light - 1)
+                {
+                    sections.setLight(neighbourIndex, static_cast<std::uint8_t>(light - 1));
+                    addQueue.push(neighbourIndex);
+                }
+            }
+        }
+    }
+}
+
+// rows copied into a snapshot like createChunkSnapshot, then the six neighbours of every solid
+// block are looked at like chunkUpdateVisibility
+template <typename BlockLayout>
+std::size_t updateVisibility(const VSBasicChunkSections<BlockLayout>& sections)
+{
+    std::vector<VSBlockID> blocks(chunkBlockCount);
+    std::vector<std::uint8_t> light(chunkBlockCount);
+    for (std::size_t rowStart = 0; rowStart < chunkBlockCount; rowStart += chunkSize.x)
+    {
+        sections.copyRowBlocks(rowStart, chunkSize.x, blocks.data() + rowStart);
+        sections.copyRowLight(rowStart, chunkSize.x, light.data() + rowStart);
+    }
+
+    std::size_t visibleBlockCount = 0;
+    for (int z = 1; z < chunkSize.z - 1; z++)
+    {
+        for (int y = 1; y < chunkSize.y - 1; y++)
+        {
+            for (int x = 1; x < chunkSize.x - 1; x++)
+            {
+                const auto blockIndex = getBlockIndex(x, y, z);
+                if (blocks[blockIndex] == 0)
+                {
+                    continue;
+                }
+                const std::size_t neighbours[] = {
+                    getBlockIndex(x - 1, y, z),
+                    getBlockIndex(x + 1, y, z),
+                    getBlockIndex(x, y - 1, z),
+                    getBlockIndex(x, y + 1, z),
+                    getBlockIndex(x, y, z - 1),
+                    getBlockIndex(x, y, z + 1)};
+                for (const auto neighbourIndex : neighbours)
+                {
+                    if (blocks[neighbourIndex] == 0)
+                    {
+                        visibleBlockCount++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return visibleBlockCount;
+}
+
+// reads the six neighbours of every block straight from the sections, the access pattern the tiles
+// are meant for
+template <typename BlockLayout>
+std::size_t readNeighbours(const VSBasicChunkSections<BlockLayout>& sections)
+{
+    std::size_t solidNeighbourCount = 0;
+    for (int z = 1; z < chunkSize.z - 1; z++)
+    {
+        for (int y = 1; y < chunkSize.y - 1; y++)
+        {
+            for (int x = 1; x < chunkSize.x - 1; x++)
+            {
+                const std::size_t neighbours[] = {
+                    getBlockIndex(x - 1, y, z),
+                    getBlockIndex(x + 1, y, z),
+                    getBlockIndex(x, y - 1, z),
+                    getBlockIndex(x, y + 1, z),
+                    getBlockIndex(x, y, z - 1),
+                    getBlockIndex(x, y, z + 1)};
+                for (const auto neighbourIndex : neighbours)
+                {
+                    solidNeighbourCount += sections.getBlock(neighbourIndex) != 0 ? 1 : 0;
+                }
+            }
+        }
+    }
+    return solidNeighbourCount;
+}
+
+template <typename Function>
+double getMillisecondsPerRun(const Function& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int repetition = 0; repetition < repetitionCount; repetition++)
+    {
+        function();
+    }
+    const std::chrono::duration<double, std::milli> duration =
+        std::chrono::steady_clock::now() - start;
+    return duration.count() / repetitionCount;
+}
+
+template <typename BlockLayout>
+void run(const char* name, const std::vector<VSBlockID>& terrain)
+{
+    VSBasicChunkSections<BlockLayout> sections(chunkSize, 0);
+    sections.assignBlocks(terrain.data());
+
+    const auto lightMilliseconds = getMillisecondsPerRun([&sections]() {
+        rebuildLight(sections);
+    });
+
+    std::size_t visibleBlockCount = 0;
+    const auto visibilityMilliseconds = getMillisecondsPerRun([&sections, &visibleBlockCount]() {
+        visibleBlockCount = updateVisibility(sections);
+    });
+
+    std::size_t solidNeighbourCount = 0;
+    const auto neighbourMilliseconds = getMillisecondsPerRun([&sections, &solidNeighbourCount]() {
+        solidNeighbourCount = readNeighbours(sections);
+    });
+
+    std::printf(
+        "%-8s light rebuild %.3f ms, visibility update %.3f ms, neighbour reads %.3f ms per chunk "
+        "(%zu visible, %zu solid neighbours)\n",
+        name,
+        lightMilliseconds,
+        visibilityMilliseconds,
+        neighbourMilliseconds,
+        visibleBlockCount,
+        solidNeighbourCount);
+}
+}  // namespace
+
+int main()
+{
+    const auto terrain = createTerrain();
+    run<VSLinearBlockLayout>("linear", terrain);
+    run<VSTiledBlockLayout>("tiled", terrain);
+    return 0;
+}
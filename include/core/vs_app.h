@@ -9,6 +9,7 @@ class VSUI;
 class VSWorld;
 class VSGame;
 class VSInputHandler;
+class VSThreadPool;
 
 struct GLFWwindow;
 
@@ -37,6 +38,8 @@ public:
 
     [[nodiscard]] std::chrono::high_resolution_clock::time_point getStartTime() const;
 
+    [[nodiscard]] VSThreadPool* getThreadPool() const;
+
     static VSApp* getInstance();
 
 private:
@@ -50,6 +53,8 @@ private:
 
     VSInputHandler* inputHandler;
 
+    VSThreadPool* threadPool;
+
     GLFWwindow* window;
 
     std::string glslVersion;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Engine wide pool of worker threads for background work (chunk rebuilds, terrain generation,
+// saving). Every worker owns a deque of tasks, idle workers steal from the other deques.
+class VSThreadPool
+{
+public:
+    explicit VSThreadPool(std::size_t workerCount);
+
+    // Finishes all queued tasks before joining the workers
+    ~VSThreadPool();
+
+    VSThreadPool(const VSThreadPool&) = delete;
+    VSThreadPool& operator=(const VSThreadPool&) = delete;
+
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+        // std::function needs a copyable target, so the task is shared
+        const auto task =
+            std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        auto result = task->get_future();
+        push([task]() { (*task)(); });
+
+        return result;
+    }
+
+    [[nodiscard]] std::size_t getWorkerCount() const;
+
+    [[nodiscard]] std::size_t getQueuedTaskCount() const;
+
+    // Worker count for the engine pool, leaves room for the render and game thread
+    static std::size_t getDefaultWorkerCount();
+
+private:
+    using VSTask = std::function<void()>;
+
+    struct VSWorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<VSTask> tasks;
+    };
+
+    std::vector<std::unique_ptr<VSWorkerQueue>> queues;
+
+    std::vector<std::thread> workers;
+
+    // sleeping workers wait on wakeUp, queuedTaskCount is only increased while holding sleepMutex
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<std::size_t> queuedTaskCount = 0;
+    bool bShouldStop = false;
+
+    std::atomic<std::size_t> nextQueueIndex = 0;
+
+    static thread_local const VSThreadPool* currentPool;
+    static thread_local std::size_t currentWorkerIndex;
+
+    void push(VSTask task);
+
+    bool popOwn(std::size_t workerIndex, VSTask& task);
+
+    bool steal(std::size_t workerIndex, VSTask& task);
+
+    void workerLoop(std::size_t workerIndex);
+};
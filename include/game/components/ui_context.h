@@ -4,6 +4,7 @@
 
 #include <entt/entity/entity.hpp>
 #include <filesystem>
+#include <future>
 #include <imgui.h>
 #include <array>
 #include <string>
@@ -18,6 +19,8 @@ struct UIContext
     bool bShouldUpdateChunks = false;
 
     bool bShouldGenerateTerrain = false;
+    // Terrain generation running on the thread pool, valid until it finished
+    std::future<void> terrainGeneration;
     bool bShouldSetGameActive = false;
     bool bIsMenuWorldInitialized = false;
     bool bShouldStartGame = false;
@@ -16,19 +16,8 @@ void deleteSelectedBuilding(entt::registry& mainRegistry, entt::registry& buildi
     const auto bounds = mainRegistry.get<Bounds>(uiContext.selectedBuildingEntity);
     const auto location = mainRegistry.get<Location>(uiContext.selectedBuildingEntity);
 
-    const auto low = location + bounds.min;
-    const auto high = location + bounds.max;
-
-    for (int x = low.x; x < high.x; x++)
-    {
-        for (int y = low.y; y < high.y; y++)
-        {
-            for (int z = low.z; z < high.z; z++)
-            {
-                worldContext.world->getChunkManager()->setBlock({x, y, z}, 0);
-            }
-        }
-    }
+    worldContext.world->getChunkManager()->enqueueFillBox(
+        location + bounds.min, location + bounds.max, 0);
 
     (void) buildingRegistry;
     unemployPopulationFromEntity(mainRegistry, buildingRegistry, uiContext.selectedBuildingEntity);
@@ -21,35 +21,29 @@ void updateMinimapSystem(entt::registry& mainRegistry)
 
         auto* chunkManager = worldContext.world->getChunkManager();
         glm::ivec3 worldSize = chunkManager->getWorldSize();
-        glm::ivec3 worldSizeHalf = worldSize / 2;
         float stepX = (float)(worldSize.x - 1) / minimap.width;
         float stepZ = (float)(worldSize.z - 1) / minimap.height;
         for (int i = -minimap.width / 2; i < minimap.width / 2; i++)
         {
             for (int j = -minimap.height / 2; j < minimap.height / 2; j++)
             {
-                for (int y = worldSizeHalf.y - 1; y >= -worldSizeHalf.y; y--)
+                int x = (int)std::round(i * stepX);
+                int z = (int)std::round(j * stepZ);
+                VSBlockID blockID = chunkManager->getSurface({x, 0, z}).blockID;
+                if (blockID > 0 && blockID < minimap.blockID2MinimapColor.size())
                 {
-                    int x = (int)std::round(i * stepX);
-                    int z = (int)std::round(j * stepZ);
-                    VSBlockID blockID = chunkManager->getBlock({x, y, z});
-                    if (blockID > 0 && blockID < minimap.blockID2MinimapColor.size())
-                    {
-                        minimap.pixels.at(
-                            (j + minimap.height / 2) * minimap.width * minimap.nrComponents +
-                            (i + minimap.width / 2) * minimap.nrComponents) =
-                            minimap.blockID2MinimapColor.at(blockID).x;
-                        minimap.pixels.at(
-                            (j + minimap.height / 2) * minimap.width * minimap.nrComponents +
-                            (i + minimap.width / 2) * minimap.nrComponents + 1) =
-                            minimap.blockID2MinimapColor.at(blockID).y;
-                        minimap.pixels.at(
-                            (j + minimap.height / 2) * minimap.width * minimap.nrComponents +
-                            (i + minimap.width / 2) * minimap.nrComponents + 2) =
-                            minimap.blockID2MinimapColor.at(blockID).z;
-                        // TODO: Are breaks still cool? Otherwise will do a while loop
-                        break;
-                    }
+                    minimap.pixels.at(
+                        (j + minimap.height / 2) * minimap.width * minimap.nrComponents +
+                        (i + minimap.width / 2) * minimap.nrComponents) =
+                        minimap.blockID2MinimapColor.at(blockID).x;
+                    minimap.pixels.at(
+                        (j + minimap.height / 2) * minimap.width * minimap.nrComponents +
+                        (i + minimap.width / 2) * minimap.nrComponents + 1) =
+                        minimap.blockID2MinimapColor.at(blockID).y;
+                    minimap.pixels.at(
+                        (j + minimap.height / 2) * minimap.width * minimap.nrComponents +
+                        (i + minimap.width / 2) * minimap.nrComponents + 2) =
+                        minimap.blockID2MinimapColor.at(blockID).z;
                 }
             }
         }
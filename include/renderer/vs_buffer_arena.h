@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+
+// Sub allocates element ranges of a single GL buffer.
+// Data stays resident on the GPU and only has to be uploaded when it changes,
+// drawing just references the ranges.
+class VSBufferArena
+{
+public:
+    struct VSAllocation
+    {
+        // offset and size are in elements, not bytes
+        std::size_t offset = 0;
+        std::size_t size = 0;
+    };
+
+    VSBufferArena(GLenum target, std::size_t elementSize, std::size_t initialCapacity);
+
+    VSBufferArena(VSBufferArena const&) = delete;
+    VSBufferArena& operator=(VSBufferArena const&) = delete;
+
+    ~VSBufferArena();
+
+    [[nodiscard]] VSAllocation allocate(std::size_t elementCount);
+
+    void free(VSAllocation& allocation);
+
+    // Frees all allocations, the buffer itself is kept
+    void reset();
+
+    void upload(
+        const VSAllocation& allocation,
+        std::size_t elementOffset,
+        const void* data,
+        std::size_t elementCount);
+
+    [[nodiscard]] GLuint getBuffer() const;
+
+    [[nodiscard]] std::size_t getElementSize() const;
+
+    [[nodiscard]] std::size_t getCapacity() const;
+
+    [[nodiscard]] std::size_t getUsedElementCount() const;
+
+    // Bytes uploaded since the last call
+    std::size_t consumeUploadedBytes();
+
+private:
+    GLenum target;
+
+    GLuint buffer = 0;
+
+    std::size_t elementSize;
+
+    std::size_t capacity = 0;
+
+    std::size_t usedElementCount = 0;
+
+    std::size_t uploadedBytes = 0;
+
+    // offset -> size of all free ranges, ordered to allow coalescing neighbours
+    std::map<std::size_t, std::size_t> freeRanges;
+
+    void grow(std::size_t minimumCapacity);
+
+    void addFreeRange(std::size_t offset, std::size_t size);
+};
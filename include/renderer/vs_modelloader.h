@@ -14,4 +14,15 @@ struct aiMaterial;
 
 VSVertexContext* loadVertexContext(std::string const& path);
 
+// Appends the first mesh of the model to the given buffers, indices are relative to the mesh
+bool loadVertexData(
+    std::string const& path,
+    std::vector<VSVertexData>& vertexData,
+    std::vector<GLuint>& triangleIndices);
+
 VSVertexContext* processMeshVertices(aiMesh*& mesh);
+
+void processMeshVertices(
+    aiMesh*& mesh,
+    std::vector<VSVertexData>& vertexData,
+    std::vector<GLuint>& triangleIndices);
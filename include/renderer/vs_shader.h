@@ -4,6 +4,7 @@
 
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_int3.hpp>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -55,6 +56,12 @@ public:
             return *this;
         }
 
+        VSShaderUniformProxy& setIVec3(const std::string& name, glm::ivec3 value)
+        {
+            glUniform3iv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+            return *this;
+        }
+
         VSShaderUniformProxy& setMat4(const std::string& name, glm::mat4 value)
         {
             glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &value[0][0]);
@@ -72,7 +79,11 @@ public:
         GLuint ID;
     };
 
-    VSShader(const char* name, bool bIsComputeShader = false);
+    // defines are injected into every stage after the #version directive
+    VSShader(
+        const char* name,
+        bool bIsComputeShader = false,
+        const std::vector<std::string>& defines = {});
 
     [[nodiscard]] GLuint getID() const;
 
@@ -89,5 +100,8 @@ private:
 
     static bool checkProgramLinkErrors(unsigned int programID);
 
-    static GLuint compileShader(const std::filesystem::path& shaderPath, GLenum shaderType);
+    static GLuint compileShader(
+        const std::filesystem::path& shaderPath,
+        GLenum shaderType,
+        const std::vector<std::string>& defines);
 };
\ No newline at end of file
@@ -15,6 +15,7 @@ struct VSUIState
     int activeBlockCount = 0;
     bool bShouldFreezeFrustum = false;
     bool bAreShadowsEnabled = false;
+    int shadowBuildMode = 0;  // 0 = CPU distance transform, 1 = GPU jump flooding
     bool bIsAmbientOcclusionEnabled = true;
     bool bShouldShowAO = false;
     bool bShouldShowUV = false;
@@ -23,7 +24,20 @@ struct VSUIState
     int totalBlockCount = 0;
     int visibleBlockCount = 0;
     int drawnBlockCount = 0;
+    int drawnTriangleCount = 0;
+    int drawnVertexCount = 0;
     int drawCallCount = 0;
+    int drawCommandCount = 0;
+    // 0 = Instanced, 1 = Multi draw indirect, 2 = GPU culled. Without GL 4.3 multi draw indirect
+    // falls back to instanced draws per chunk.
+    int chunkDrawMode = 1;
+    int uploadedInstanceBytes = 0;
+    int chunkMemoryMiB = 0;
+    int shadowPageCount = 0;
+    int visibilityRebuildQueueSize = 0;
+    float visibilityRebuildWaitMs = 0.F;
+    int shadowRebuildQueueSize = 0;
+    float shadowRebuildWaitMs = 0.F;
     std::ostringstream logStream;
     glm::vec3 directLightDir = {-0.4F, 0.7F, -0.6F};
 
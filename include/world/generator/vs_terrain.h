@@ -6,16 +6,24 @@
 
 namespace VSTerrainGeneration
 {
+    // The build functions fill a copy of the blocks on the calling thread and hand it to the
+    // chunk manager with setWorldData, the chunks are never written from there.
     void buildTerrain(VSWorld* world);
     void buildDesert(VSWorld* world);
     void buildMountains(VSWorld* world);
     void buildStandard(VSWorld* world);
+    // Queues the plane as an edit, safe to call from the game thread
     void buildEditorPlane(VSWorld* world);
 
-    void treeAt(VSWorld* world, int x, int y, int z);
-    void birchtreeAt(VSWorld* world, int x, int y, int z);
-    void cactusAt(VSWorld* world, int x, int y, int z);
-    void placeModelAt(VSWorld* world, VSChunkManager::VSBuildingData build, int x, int y, int z);
+    void treeAt(VSChunkManager::VSWorldData& worldData, int x, int y, int z);
+    void birchtreeAt(VSChunkManager::VSWorldData& worldData, int x, int y, int z);
+    void cactusAt(VSChunkManager::VSWorldData& worldData, int x, int y, int z);
+    void placeModelAt(
+        VSChunkManager::VSWorldData& worldData,
+        VSChunkManager::VSBuildingData build,
+        int x,
+        int y,
+        int z);
 
     void printMap();
 };
\ No newline at end of file
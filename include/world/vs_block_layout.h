@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/vec3.hpp>
+
+// Order of the blocks of a box in memory, set up once for the size of the box. Layouts map block
+// coordinates inside the box to an index in [0, size.x * size.y * size.z).
+
+// Rows along x one after the other, x + y * size.x + z * size.x * size.y
+class VSLinearBlockLayout
+{
+public:
+    // rows along x are contiguous, so they can be copied as a whole
+    static constexpr bool bAreRowsContiguous = true;
+
+    VSLinearBlockLayout() = default;
+
+    explicit VSLinearBlockLayout(const glm::ivec3& size)
+        : strideY(size.x), strideZ(static_cast<std::size_t>(size.x) * size.y)
+    {
+    }
+
+    [[nodiscard]] std::size_t getIndex(const glm::ivec3& coordinates) const
+    {
+        return coordinates.x + coordinates.y * strideY + coordinates.z * strideZ;
+    }
+
+private:
+    std::size_t strideY = 0;
+
+    std::size_t strideZ = 0;
+};
+
+// Tiles of 4x4x4 blocks one after the other, in linear order inside each tile and across the
+// tiles, so the neighbours along y and z are close to a block instead of a row or a layer away.
+// A tile holds 64 blocks: its light bytes fill one cache line, its palette indices take 8 to 64
+// bytes depending on the bits per block. Axes whose size is not a multiple of 4 use tiles of a
+// single block along that axis.
+class VSTiledBlockLayout
+{
+public:
+    static constexpr bool bAreRowsContiguous = false;
+
+    VSTiledBlockLayout() = default;
+
+    explicit VSTiledBlockLayout(const glm::ivec3& size)
+        : tileShift(
+              size.x % tileSize == 0 ? tileShiftBits : 0,
+              size.y % tileSize == 0 ? tileShiftBits : 0,
+              size.z % tileSize == 0 ? tileShiftBits : 0)
+    {
+        const auto tileCount = glm::ivec3(size.x >> tileShift.x, size.y >> tileShift.y, 0);
+        tileStrideY = tileCount.x;
+        tileStrideZ = static_cast<std::size_t>(tileCount.x) * tileCount.y;
+        tileVolumeShift = tileShift.x + tileShift.y + tileShift.z;
+    }
+
+    [[nodiscard]] std::size_t getIndex(const glm::ivec3& coordinates) const
+    {
+        const auto tileIndex = (coordinates.x >> tileShift.x) +
+                               (coordinates.y >> tileShift.y) * tileStrideY +
+                               (coordinates.z >> tileShift.z) * tileStrideZ;
+        const auto localIndex =
+            (coordinates.x & ((1 << tileShift.x) - 1)) |
+            ((coordinates.y & ((1 << tileShift.y) - 1)) << tileShift.x) |
+            ((coordinates.z & ((1 << tileShift.z) - 1)) << (tileShift.x + tileShift.y));
+        return (tileIndex << tileVolumeShift) | static_cast<std::size_t>(localIndex);
+    }
+
+    // blocks from x on along the row that follow each other in memory, up to the end of the tile
+    [[nodiscard]] int getRowRunLength(int x) const
+    {
+        return (1 << tileShift.x) - (x & ((1 << tileShift.x) - 1));
+    }
+
+private:
+    static constexpr int tileSize = 4;
+
+    static constexpr int tileShiftBits = 2;
+
+    glm::ivec3 tileShift{0};
+
+    std::size_t tileStrideY = 0;
+
+    std::size_t tileStrideZ = 0;
+
+    int tileVolumeShift = 0;
+};
@@ -1,23 +1,38 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <glm/fwd.hpp>
 #include <glm/gtx/component_wise.hpp>
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/vector_relational.hpp>
+#include <limits>
+#include <mutex>
 #include <vector>
 #include <array>
 #include <bitset>
 #include <renderer/vs_shader.h>
 #include <future>
+#include <memory>
+#include <memory_resource>
+#include <queue>
+#include <unordered_map>
+#include <concurrentqueue/concurrentqueue.h>
 
 #include "core/vs_core.h"
 
+#include "renderer/vs_buffer_arena.h"
 #include "renderer/vs_drawable.h"
 #include "renderer/vs_vertex_context.h"
 
+#include "world/vs_chunk_memory.h"
+#include "world/vs_chunk_pool.h"
+#include "world/vs_chunk_rebuild_queue.h"
 #include "world/vs_chunk_update.h"
+#include "world/vs_chunk_sections.h"
 
 #include "vs_block.h"
 
@@ -25,36 +40,195 @@ struct VSVertexContext;
 
 class VSShader;
 
+// How visible blocks are turned into geometry
+enum class VSChunkMeshingMode
+{
+    // one instance of a pre-built cube mesh per visible block
+    CubeInstancing,
+    // coplanar faces with the same block and light are merged into larger quads
+    Greedy
+};
+
 class VSChunkManager : public IVSDrawable
 {
-    struct VSChunk
+    // Light spread by flood fill, each channel has its own level per block
+    enum VSLightChannel : std::uint8_t
+    {
+        // light of emitting blocks
+        BlockLight = 0,
+        // light of the sky, seeded from the column heightmaps
+        SkyLight = 1
+    };
+
+    static constexpr std::size_t lightChannelCount = 2;
+
+    // level of channel in a light byte, see VSChunk::VSBlockData::light
+    static constexpr std::uint8_t getLightLevel(std::uint8_t packedLight, VSLightChannel channel)
+    {
+        return (packedLight >> (channel * 4)) & 0x0FU;
+    }
+
+    // Starts on its own cache line, see VSChunkPool
+    struct alignas(64) VSChunk
     {
+        // Inclusive box of chunk local block coordinates
+        struct VSBlockRegion
+        {
+            glm::ivec3 min = glm::ivec3(std::numeric_limits<int>::max());
+            glm::ivec3 max = glm::ivec3(std::numeric_limits<int>::min());
+
+            [[nodiscard]] bool isEmpty() const
+            {
+                return glm::any(glm::greaterThan(min, max));
+            }
+
+            [[nodiscard]] bool contains(const glm::ivec3& blockCoordinates) const
+            {
+                return glm::all(glm::greaterThanEqual(blockCoordinates, min)) &&
+                       glm::all(glm::lessThanEqual(blockCoordinates, max));
+            }
+
+            [[nodiscard]] std::size_t getBlockCount() const
+            {
+                return isEmpty() ? 0 : static_cast<std::size_t>(glm::compMul(max - min + 1));
+            }
+
+            void add(const VSBlockRegion& other)
+            {
+                min = glm::min(min, other.min);
+                max = glm::max(max, other.max);
+            }
+        };
+
+        // 8 byte instance, decoded in Chunk.vs
         struct VSVisibleBlockInfo
         {
-            glm::vec3 locationWorldSpace;
-            VSBlockID id;
-            std::uint32_t lightRight;
-            std::uint32_t lightLeft;
-            std::uint32_t lightTop;
-            std::uint32_t lightBottom;
-            std::uint32_t lightFront;
-            std::uint32_t lightBack;
+            // chunk local x, y and z followed by the chunk index, see locationBitCounts
+            std::uint32_t packedLocation;
+            // block id in the lowest byte followed by 4 bit light per face
+            // in the order right, left, top, bottom, front, back
+            std::uint32_t packedBlock;
         };
 
         using VSVisibleBlockInfos = std::array<std::vector<VSVisibleBlockInfo>, 64>;
 
-        std::vector<VSBlockID> blocks;
+        // one entry per block of the chunk, set if the block is visible
+        using VSBlockVisibility = std::pmr::vector<bool>;
 
-        std::vector<float> lightLevel;
+        // Blocks, light and occupancy of a chunk. The thread changing blocks edits the current
+        // version in place until a reader freezes it, the next edit continues on a copy. Frozen
+        // versions stay alive as long as a reader holds them.
+        struct VSBlockData
+        {
+            explicit VSBlockData(std::pmr::memory_resource* memory)
+                : sections(memory), occupancy(memory)
+            {
+            }
+
+            // Palette packed blocks and the light of each block. The light holds a level of each
+            // VSLightChannel, 0 to maxLight, one nibble per channel.
+            VSChunkSections sections;
+
+            // One word per row along x, bit x is set if the block is not air.
+            // Empty if the chunk is wider than 64 blocks.
+            std::pmr::vector<std::uint64_t> occupancy;
+
+            std::atomic<bool> bIsFrozen = false;
+
+            [[nodiscard]] std::uint8_t
+            getLight(VSLightChannel channel, std::size_t blockIndex) const
+            {
+                return getLightLevel(sections.getLight(blockIndex), channel);
+            }
+
+            void setLight(VSLightChannel channel, std::size_t blockIndex, std::uint8_t level)
+            {
+                const auto shift = channel * 4;
+                const auto keptLight = sections.getLight(blockIndex) & ~(0x0FU << shift);
+                sections.setLight(
+                    blockIndex, static_cast<std::uint8_t>(keptLight | (level << shift)));
+            }
+        };
 
-        std::vector<bool> bIsBlockVisible;
+        // Vertex of a greedy meshed quad, position is in world space
+        struct VSMeshVertex
+        {
+            glm::vec3 position;
+            glm::vec3 normal;
+            std::uint32_t id;
+            float lightLevel;
+        };
+
+        struct VSVisibilityResult
+        {
+            VSVisibleBlockInfos visibleBlockInfos;
+            // only filled when greedy meshing, 4 vertices per quad
+            std::vector<VSMeshVertex> meshVertices;
+            // 2 bits per block (visible, solid), only filled if shadows can be built on the GPU
+            std::vector<std::uint32_t> shadowSeeds;
+            // first word of the chunk covered by shadowSeeds
+            std::size_t shadowSeedOffset = 0;
+            // if set, visibleBlockInfos only holds the blocks inside region and replaces the
+            // entries of those blocks
+            bool bIsPartial = false;
+            VSBlockRegion region;
+            // visibility of all blocks of the chunk after the update
+            std::shared_ptr<VSBlockVisibility> bIsBlockVisible;
+        };
+
+        // current version, only replaced by the thread changing blocks, see getWritableBlockData
+        std::shared_ptr<VSBlockData> blockData;
+
+        // Chunk local y of the highest solid block per column, -1 for empty columns.
+        // Indexed by x + z * chunkSize.x.
+        std::vector<std::int16_t> heightmap;
+
+        // Only replaced on the main thread when a visibility update is uploaded, updates read
+        // the version they were started with. Not const so resetChunk can reuse it once nothing
+        // else holds it.
+        std::shared_ptr<VSBlockVisibility> bIsBlockVisible;
 
         std::atomic<bool> bIsDirty;
 
         std::atomic<bool> bShouldRebuildShadows;
 
+        // Increased on every change, rebuilds started from an older generation are dropped
+        std::atomic<std::uint32_t> generation;
+
+        std::atomic<std::uint32_t> shadowGeneration;
+
+        // blocks changed since the chunk was last picked up
+        VSBlockRegion dirtyRegion;
+
+        std::mutex dirtyRegionMutex;
+
+        // Only used on the main thread. Picked up blocks not covered by a started update yet and
+        // the blocks covered by the running update, kept until its result is uploaded.
+        VSBlockRegion rebuildRegion;
+
+        VSBlockRegion updateRegion;
+
         VSVisibleBlockInfos visibleBlockInfos;
 
+        // GPU copy of visibleBlockInfos, all face combinations are stored back to back
+        VSBufferArena::VSAllocation instanceAllocation;
+
+        // offset of each face combination inside instanceAllocation
+        std::array<std::size_t, 64> instanceOffsets{};
+
+        // Instances each face combination has room for at its offset, partial updates fill the
+        // room before the chunk is laid out again
+        std::array<std::size_t, 64> instanceCapacities{};
+
+        // GPU copy of the greedy mesh vertices
+        VSBufferArena::VSAllocation meshAllocation;
+
+        std::size_t meshQuadCount = 0;
+
+        std::size_t triangleCount = 0;
+
+        std::size_t vertexCount = 0;
+
         glm::vec3 chunkLocation = glm::vec3(0.F);
     };
 
@@ -63,8 +237,12 @@ public:
     struct VSWorldData
     {
         glm::ivec3 chunkSize;
-        glm::ivec2 chunkCount;
+        glm::ivec3 chunkCount;
+        // ordered by chunk, then by block inside the chunk, both like the chunk indices
         std::vector<VSBlockID> blocks;
+
+        // Same world coordinates as the chunk manager, locations outside of the world are skipped
+        void setBlock(const glm::vec3& location, VSBlockID blockID);
     };
 
     struct VSBuildingData
@@ -81,13 +259,23 @@ public:
         VSBlockID blockID = VS_DEFAULT_BLOCK_ID;
     };
 
-    VSChunkManager();
+    explicit VSChunkManager(VSChunkMeshingMode meshingMode = VSChunkMeshingMode::CubeInstancing);
 
     VSBlockID getBlock(const glm::vec3& location) const;
 
-    void setBlock(const glm::vec3& location, VSBlockID blockID);
+    // Edits queued from any thread, updateChunks applies them in order per thread within
+    // editBlockBudget. Boxes span from low up to but not including high, like Bounds.
+    void enqueueSetBlock(const glm::vec3& location, VSBlockID blockID);
 
-    void addEmission(const glm::vec3& location, float emission);
+    void enqueueFillBox(const glm::vec3& low, const glm::vec3& high, VSBlockID blockID);
+
+    // Places blocks of size, ordered by x + y * size.x + z * size.x * size.y, at origin.
+    // Rotated stamps swap x and z.
+    void enqueueStamp(
+        const glm::vec3& origin,
+        const glm::ivec3& size,
+        std::vector<VSBlockID> blocks,
+        bool bIsRotated);
 
     glm::ivec3 getWorldSize() const;
 
@@ -107,9 +295,19 @@ public:
 
     void setColorOverride(const glm::vec3& newColorOverride);
 
-    void setChunkDimensions(const glm::ivec3& inChunkSize, const glm::ivec2& inChunkCount);
+    // Sets the world up again in the next updateChunks. Dimensions whose packed instances would
+    // need more than 32 bits are refused and the current world is kept.
+    void setChunkDimensions(const glm::ivec3& inChunkSize, const glm::ivec3& inChunkCount);
+
+    // Empty world data of the current dimensions, to be filled on another thread
+    [[nodiscard]] VSWorldData createWorldData() const;
 
-    void setWorldData(const VSWorldData& worldData);
+    // Replaces all blocks in the next updateChunks, data not matching the dimensions by then is
+    // dropped. Safe to call from any thread.
+    void setWorldData(VSWorldData worldData);
+
+    // True from setWorldData until updateChunks has replaced the blocks
+    [[nodiscard]] bool isWorldDataPending() const;
 
     std::size_t getChunkBlockCount() const;
 
@@ -119,162 +317,704 @@ public:
 
     std::size_t getDrawnBlockCount() const;
 
+    std::size_t getDrawnTriangleCount() const;
+
+    std::size_t getDrawnVertexCount() const;
+
     std::size_t getTotalChunkCount() const;
 
     std::size_t getDrawCallCount() const;
 
+    std::size_t getDrawCommandCount() const;
+
+    std::size_t getUploadedInstanceBytes() const;
+
+    // bytes reserved for the blocks, light and visibility of the chunks
+    std::size_t getChunkMemoryBytes() const;
+
+    std::size_t getShadowPageCount() const;
+
+    std::size_t getVisibilityRebuildQueueSize() const;
+
+    float getVisibilityRebuildWaitSeconds() const;
+
+    std::size_t getShadowRebuildQueueSize() const;
+
+    float getShadowRebuildWaitSeconds() const;
+
     bool shouldReinitializeChunks() const;
 
     bool isLocationInBounds(const glm::vec3& location) const;
 
     VSTraceResult lineTrace(const glm::vec3& start, const glm::vec3& end) const;
 
+    // Top face of the highest solid block in the column at location, without a hit if the
+    // column is empty. Only reads the copy of the surfaces made after every edit, so it can be
+    // called from any thread.
+    VSTraceResult getSurface(const glm::vec3& location) const;
+
     // This method is used to retrieve the data to save a scene.
     [[nodiscard]] VSWorldData getData() const;
 
-    void initFromData(const VSWorldData& data);
+    void initFromData(VSWorldData data);
 
 private:
+    // Block data and visibility of all chunks, declared first so it outlives everything holding
+    // a version of them
+    VSChunkMemory chunkMemory;
+
+    // ordered x + y * chunkCount.x + z * chunkCount.x * chunkCount.y, all owned by chunkPool
     std::vector<VSChunk*> chunks;
 
+    VSChunkPool<VSChunk> chunkPool;
+
     glm::vec3 origin{};
 
     glm::ivec3 chunkSize{};
 
-    glm::ivec2 chunkCount{};
+    glm::ivec3 chunkCount{};
 
     glm::ivec3 worldSize{};
 
     glm::ivec3 worldSizeHalf{};
 
+    // Dimensions of the next world, set from any thread while holding worldDataMutex and taken
+    // over by initializeChunks
     glm::ivec3 newChunkSize{};
 
-    glm::ivec2 newChunkCount{};
+    glm::ivec3 newChunkCount{};
 
     glm::ivec3 newWorldSize{};
 
     glm::ivec3 newWorldSizeHalf{};
 
+    VSChunkMeshingMode meshingMode;
+
     VSShader chunkShader = VSShader("Chunk");
 
     std::atomic<bool> bShouldReinitializeChunks = false;
 
     std::atomic<bool> bShouldInitializeFromData = false;
 
+    // Odd while blocks are changed. Readers freezing block data wait for the running edit, edits
+    // started later see the frozen flag and copy the data instead.
+    std::atomic<std::uint64_t> editEpoch = 0;
+
     bool bIsFrustumCullingEnabled = true;
 
     glm::vec3 colorOverride{1.F, 1.F, 1.F};
 
+    // guards worldDataFromFile and the dimensions of the next world, both are set by the threads
+    // generating or loading the world
+    std::mutex worldDataMutex;
+
     VSWorldData worldDataFromFile;
 
     static constexpr auto faceCombinationCount = 64;
 
-    std::array<VSVertexContext*, faceCombinationCount> vertexContexts;
+    // Layout defined by glMultiDrawElementsIndirect
+    struct VSDrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Location of each cube mesh inside cubeVertexContext
+    struct VSCubeMeshRange
+    {
+        GLuint firstIndex = 0;
+        GLuint indexCount = 0;
+        GLint baseVertex = 0;
+        GLuint vertexCount = 0;
+    };
+
+    // All face combination meshes merged into one vertex and index buffer
+    VSVertexContext* cubeVertexContext = nullptr;
+
+    std::array<VSCubeMeshRange, faceCombinationCount> cubeMeshRanges;
+
+    GLuint drawCommandBuffer = 0;
+
+    std::vector<VSDrawElementsIndirectCommand> drawCommands;
+
+    // Draw command of one chunk and face combination, matches CullEntry in ChunkCull.cs
+    struct VSCullEntry
+    {
+        VSDrawElementsIndirectCommand command;
+        GLuint chunkIndex;
+    };
+
+    static constexpr GLuint cullWorkGroupSize = 64;
+
+    // Only created if compute shaders are supported
+    std::unique_ptr<VSShader> chunkCullShader;
+
+    GLuint cullEntryBuffer = 0;
+
+    GLuint culledDrawCommandBuffer = 0;
+
+    GLuint culledDrawCommandCountBuffer = 0;
+
+    // GL 4.6 reads the draw count from culledDrawCommandCountBuffer, older versions draw all
+    // commands and rely on the culled ones being zero
+    bool bCanDrawIndirectCount = false;
+
+    std::size_t cullEntryCount = 0;
+
+    bool bShouldRebuildCullEntries = true;
+
+    // Only created if compute shaders are supported
+    std::unique_ptr<VSShader> shadowJumpFloodShader;
+
+    static constexpr GLuint jumpFloodWorkGroupSize = 4;
+
+    // jump flooding is fast but still stalls the frame if all chunks are rebuilt at once
+    static constexpr std::size_t maxGPUShadowUpdatesPerFrame = 4;
+
+    // shadowSeeds of all chunks, chunk after chunk
+    GLuint shadowSeedBuffer = 0;
+
+    // closest visible block of each block in the region, swapped after each pass
+    std::array<GLuint, 2> jumpFloodBuffers{};
+
+    // Largest shadow region the jump flood can pack seeds for, x in 11 bits, y in 10 and z in 11,
+    // see packCoordinates in ShadowJumpFlood.cs. The all ones coordinate marks a missing seed.
+    static constexpr auto maxJumpFloodRegionSize = glm::ivec3(2047, 1023, 2047);
 
-    std::array<GLuint, faceCombinationCount> visibleBlockInfoBuffers;
+    // larger chunks build their shadows on the CPU
+    static bool doesShadowRegionFitJumpFlood(const glm::ivec3& chunkSizeToCheck);
 
-    glm::mat4 frozenVPMatrix;
-    glm::vec3 frozenCameraPos;
+    // packed location and packed block
+    static constexpr GLuint instanceAttribCount = 2;
+
+    // Bits used for the chunk local x, y and z inside packedLocation
+    glm::uvec3 locationBitCounts{};
+
+    // One vec4 per chunk, read by the culling shader and as a buffer texture by Chunk.vs
+    GLuint chunkLocationBuffer = 0;
+
+    GLuint chunkLocationTexture = 0;
+
+    GLuint chunkLocationTextureID;
+
+    static constexpr std::size_t initialInstanceArenaCapacity = 1 << 16;
+
+    std::unique_ptr<VSBufferArena> instanceArena;
+
+    std::size_t uploadedInstanceBytes = 0;
+
+    static constexpr std::size_t initialMeshArenaCapacity = 1 << 18;
+
+    static constexpr std::size_t initialQuadIndexCapacity = 1 << 16;
+
+    // Only used when greedy meshing
+    std::unique_ptr<VSBufferArena> meshArena;
+
+    GLuint meshVertexArrayObject = 0;
+
+    // Two triangles per quad, shared by all chunk meshes
+    GLuint quadIndexBuffer = 0;
+
+    std::size_t quadIndexCapacity = 0;
+
+    // also used to prioritize chunk rebuilds, so they start out as a camera at the origin
+    glm::mat4 frozenVPMatrix = glm::mat4(1.F);
+    glm::vec3 frozenCameraPos = glm::vec3(0.F);
 
     std::uint32_t drawCallCount;
 
+    std::uint32_t drawCommandCount = 0;
+
     std::uint32_t drawnBlockCount;
 
+    std::size_t drawnTriangleCount = 0;
+
+    std::size_t drawnVertexCount = 0;
+
     GLuint spriteTexture;
 
     GLuint spriteTextureID;
 
-    GLuint shadowTexture;
+    // The shadow distance field is stored in bricks, only bricks close to the surface get a page
+    // in the pool. All other bricks store a single value in the brick table.
+    static constexpr int shadowBrickSize = 8;
+
+    // Distances of the shadow field are capped at this many blocks, so a block only changes the
+    // field of chunks that close to it
+    static constexpr float shadowDistanceLimit = 2.F * shadowBrickSize;
+
+    // a page also holds the first texel of the next brick on each axis for linear filtering
+    static constexpr int shadowPageSize = shadowBrickSize + 1;
+
+    // pages along x and y of the pool, the pool grows along z
+    static constexpr int shadowPoolPagesPerAxis = 64;
+
+    // Bricks overlapping one chunk
+    struct VSShadowBrickLayout
+    {
+        glm::ivec3 firstBrick{};
+        glm::ivec3 brickCount{};
+        std::vector<bool> bNeedsPage;
+    };
+
+    struct VSShadowBricks
+    {
+        VSShadowBrickLayout layout;
+        // smallest distance and distance at the center of each brick, used without a page
+        std::vector<float> minDistances;
+        std::vector<float> centerDistances;
+        // shadowPageSize^3 values for each brick that needs a page, in brick order
+        std::vector<float> pageDistances;
+    };
+
+    // brick pool
+    GLuint shadowTexture = 0;
 
     GLuint shadowTextureID;
 
-    using VSShadwoChunkUpdate = VSChunkUpdate<std::vector<float>>;
+    // page coordinates of each brick or -1 and the uniform value of the brick
+    GLuint shadowBrickTable = 0;
 
-    std::map<VSChunk*, std::shared_ptr<VSShadwoChunkUpdate>> activeShadowBuildTasks;
+    GLuint shadowBrickTableID;
 
-    using VSVisibilityChunkUpdate = VSChunkUpdate<VSChunk::VSVisibleBlockInfos>;
+    glm::ivec3 shadowBrickCount{};
 
-    std::map<VSChunk*, std::shared_ptr<VSVisibilityChunkUpdate>> activeVisibilityBuildTasks;
+    int shadowPoolPageCountZ = 0;
+
+    // page of each brick, -1 if the brick has none
+    std::vector<std::int32_t> shadowBrickPages;
+
+    std::vector<std::int32_t> freeShadowPages;
+
+    // pages below this index have been handed out at least once
+    std::int32_t nextShadowPage = 0;
+
+    // used by the GPU path to pass the pages of a chunk and collect the brick minimum
+    GLuint shadowBrickPageBuffer = 0;
+
+    GLuint shadowBrickMinDistanceBuffer = 0;
+
+    using VSShadwoChunkUpdate = VSChunkUpdate<VSShadowBricks>;
+
+    VSChunkUpdateTable<VSShadowBricks> activeShadowBuildTasks;
+
+    using VSVisibilityChunkUpdate = VSChunkUpdate<VSChunk::VSVisibilityResult>;
+
+    VSChunkUpdateTable<VSChunk::VSVisibilityResult> activeVisibilityBuildTasks;
+
+    // Chunks marked dirty since the last frame, each chunk is queued once until it is picked up
+    moodycamel::ConcurrentQueue<std::size_t> dirtyChunkIndices;
+
+    moodycamel::ConcurrentQueue<std::size_t> shadowDirtyChunkIndices;
+
+    // Block edit queued by a game system, fills the box with blockID if blocks is empty
+    struct VSEditCommand
+    {
+        // first block of the box in world coordinates
+        glm::ivec3 origin{};
+        // box size in world space, stamps are rotated already
+        glm::ivec3 size{};
+        VSBlockID blockID = VS_DEFAULT_BLOCK_ID;
+        // stamp blocks in the order of the unrotated size
+        std::vector<VSBlockID> blocks;
+        bool bIsRotated = false;
+    };
+
+    moodycamel::ConcurrentQueue<VSEditCommand> editCommands;
+
+    // blocks covered by queued edits per frame, edits past it wait for the next frame.
+    // Every frame applies at least one edit.
+    static constexpr std::size_t editBlockBudget = 1 << 16;
+
+    // only used by the thread changing blocks during an edit
+    std::vector<glm::ivec3> editChangedLocations;
+
+    std::unordered_map<std::size_t, VSChunk::VSBlockRegion> editChangedRegions;
+
+    struct VSColumnSurface
+    {
+        // zero based world y of the highest solid block, -1 if the column is empty
+        std::int16_t height = -1;
+        VSBlockID blockID = VS_DEFAULT_BLOCK_ID;
+    };
+
+    // Surfaces of all block columns together with the dimensions of the world they belong to
+    struct VSColumnSurfaces
+    {
+        glm::ivec3 chunkSize{};
+        glm::ivec3 chunkCount{};
+        glm::ivec3 worldSizeHalf{};
+        // per column of chunks, indexed by x + z * chunkSize.x inside and
+        // chunk x + chunk z * chunkCount.x outside
+        std::vector<std::shared_ptr<const std::vector<VSColumnSurface>>> columns;
+    };
+
+    // The heightmaps are only read by the thread changing blocks, it replaces this copy as a whole
+    // once an edit is done or the world is set up again, so getSurface can be called from any
+    // thread.
+    std::shared_ptr<const VSColumnSurfaces> columnSurfaces;
+
+    VSChunkRebuildQueue visibilityRebuildQueue;
+
+    VSChunkRebuildQueue shadowRebuildQueue;
+
+    // in blocks, chunks outside the frustum are treated as if they were this much further away
+    static constexpr float rebuildOutsideFrustumPenalty = 256.F;
+
+    // in blocks per second waited, keeps far away chunks from starving
+    static constexpr float rebuildPriorityPerSecond = 64.F;
+
+    // dirty regions covering more than this part of a chunk rebuild the whole chunk
+    static constexpr std::size_t partialRebuildMaxBlockFraction = 8;
 
     const static inline auto maxShadowUpdateThreads =
         std::thread::hardware_concurrency() == 0 ? 4 : std::thread::hardware_concurrency() + 1;
 
-    const static inline std::vector<float> blockEmission = {/*Air=0*/ 0.F,
-                                                            /*Stone=1*/ 0.F,
-                                                            /*Water=2*/ 0.F,
-                                                            /*Grass=3*/ 0.F,
-                                                            /*Wood=4*/ 0.F,
-                                                            /*Sand=5*/ 0.F,
-                                                            /*Leaf=6*/ 0.F,
-                                                            /*Lava=7*/ 12.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F,
-                                                            0.F};
+    // block light level at emitting blocks, it drops by one per block of air
+    const static inline std::vector<std::uint8_t> blockEmission = {/*Air=0*/ 0,
+                                                                   /*Stone=1*/ 0,
+                                                                   /*Water=2*/ 0,
+                                                                   /*Grass=3*/ 0,
+                                                                   /*Wood=4*/ 0,
+                                                                   /*Sand=5*/ 0,
+                                                                   /*Leaf=6*/ 0,
+                                                                   /*Lava=7*/ 12,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0,
+                                                                   0};
+
+    static constexpr std::uint8_t maxLight = 15;
+
+    // light sample of one light level in the units of VSFaceLight, 2 light value per block light
+    // level. Full sky light matches the constant ambient light used before sky light existed.
+    static constexpr std::uint16_t blockLightSampleScale = 2 * 15;
+
+    static constexpr std::uint16_t skyLightSampleScale = 8;
+
+    // Block and light level of a light propagation step, block in zero based world coordinates
+    struct VSLightNode
+    {
+        glm::ivec3 location;
+        std::uint8_t light;
+    };
+
+    // per VSLightChannel, only used by the thread editing blocks
+    std::array<std::queue<VSLightNode>, lightChannelCount> lightAddQueues;
+
+    std::array<std::queue<VSLightNode>, lightChannelCount> lightRemoveQueues;
+
+    // blocks whose light changed during propagation by chunk index
+    std::unordered_map<std::size_t, VSChunk::VSBlockRegion> lightChangedRegions;
 
     void initializeChunks();
 
-    glm::ivec2 getChunkCount() const;
+    glm::ivec3 getChunkCount() const;
+
+    // Empties a new or recycled chunk, recycled chunks keep the buffers they can reuse
+    void resetChunk(VSChunk* chunk) const;
+
+    // Thread safe, queues the chunk for a rebuild
+    void markChunkDirty(std::size_t chunkIndex);
+
+    // Only the blocks inside region are evaluated again by the next rebuild
+    void markChunkDirty(std::size_t chunkIndex, const VSChunk::VSBlockRegion& region);
+
+    // Marks the region and the blocks around it dirty, in all chunks they reach into
+    void markRegionNeighbourhoodDirty(
+        const glm::ivec3& chunkCoordinates,
+        const VSChunk::VSBlockRegion& region);
+
+    void applyEditCommands();
+
+    // Sets the blocks of the box at the zero based origin as one edit, getBlockID gets the offset
+    // of each block inside the box. Blocks outside of the world are skipped.
+    void editBlocks(
+        const glm::ivec3& zeroBaseOrigin,
+        const glm::ivec3& size,
+        const std::function<VSBlockID(const glm::ivec3&)>& getBlockID);
+
+    // Queues the light changes after the block at the zero based world location changed, the
+    // heightmap has to be updated first
+    void queueLightUpdate(const glm::ivec3& zeroBaseLocation);
+
+    // Spreads the light of all emitting blocks and the sky again, used after blocks are replaced
+    // in bulk
+    void rebuildLight();
+
+    // Runs the queued removals and then the queued additions, marks the changed chunks dirty.
+    // Sky light keeps its full level while going down.
+    void propagateLight(VSLightChannel channel);
+
+    void setLight(
+        VSLightChannel channel,
+        std::size_t chunkIndex,
+        std::size_t blockIndex,
+        std::uint8_t light);
+
+    void updateHeightmap(VSChunk* chunk, const glm::ivec3& blockCoordinates) const;
+
+    void rebuildHeightmap(VSChunk* chunk) const;
+
+    // Zero based world y of the highest solid block in the column, -1 if the column is empty.
+    // Goes down the chunks stacked along y until one of them has a solid block in the column.
+    int getColumnHeight(const glm::ivec2& zeroBaseColumn) const;
+
+    // Copies the surfaces of the given columns of chunks from their heightmaps into a new
+    // columnSurfaces, the other columns are shared with the previous one
+    void publishColumnSurfaces(const std::vector<glm::ivec2>& chunkColumns);
+
+    std::vector<glm::ivec2> getAllChunkColumns() const;
+
+    bool isZeroBaseLocationInBounds(const glm::ivec3& zeroBaseLocation) const;
 
-    VSChunk* createChunk() const;
+    VSChunk::VSBlockRegion getChunkRegion() const;
 
-    void deleteChunk(VSChunk* chunk);
+    void markChunkShadowsDirty(std::size_t chunkIndex);
 
+    // Empty block data and visibility from chunkMemory, can be called from any thread
+    std::shared_ptr<VSChunk::VSBlockData> createBlockData() const;
+
+    std::shared_ptr<VSChunk::VSBlockVisibility> createBlockVisibility() const;
+
+    // Block data of the chunk for the thread changing blocks, copies a frozen version first
+    VSChunk::VSBlockData* getWritableBlockData(std::size_t chunkIndex);
+
+    // Current block data of the chunk, it is not changed anymore while the caller holds it.
+    // Must not be called from within an edit.
+    std::shared_ptr<const VSChunk::VSBlockData> freezeBlockData(std::size_t chunkIndex) const;
+
+    // Frozen block data and visibility of the chunks in the shadow region of a chunk, in the
+    // order x + y * region width + z * region width * region height
+    struct VSShadowSources
+    {
+        std::vector<std::shared_ptr<const VSChunk::VSBlockData>> blockData;
+        std::vector<std::shared_ptr<const VSChunk::VSBlockVisibility>> bIsBlockVisible;
+    };
+
+    void startShadowUpdate(std::size_t chunkIndex);
+
+    // Uploads the result of a finished shadow update
     void updateShadows(std::size_t chunkIndex);
 
-    std::vector<float> chunkUpdateShadow(
+    VSShadowBricks chunkUpdateShadow(
         const std::atomic<bool>& bShouldCancel,
         std::atomic<bool>& bIsReady,
-        std::size_t chunkIndex) const;
+        std::size_t chunkIndex,
+        const VSShadowSources& sources) const;
+
+    // First and last chunk coordinates used to build the shadows of a chunk
+    std::tuple<glm::ivec3, glm::ivec3> getShadowRegion(std::size_t chunkIndex) const;
+
+    VSShadowBrickLayout getShadowBrickLayout(std::size_t chunkIndex) const;
+
+    // Empty pool and brick table, all bricks lose their pages
+    void createShadowBrickPool(int pageCountZ);
+
+    // Layers of pages are clamped to what the GL supports
+    [[nodiscard]] int getMaxShadowPageCountZ() const;
+
+    [[nodiscard]] GLuint createShadowPoolTexture(int pageCountZ) const;
+
+    // Makes room for more pages, pages already written keep their place and their distances
+    void growShadowBrickPool(int pageCountZ);
 
+    // Returns the page of each brick of the layout, -1 if it has none
+    std::vector<std::int32_t> assignShadowPages(const VSShadowBrickLayout& layout);
+
+    glm::ivec3 getShadowPageOrigin(std::int32_t page) const;
+
+    void uploadShadowBricks(const VSShadowBricks& bricks);
+
+    void updateShadowsOnGPU(std::size_t chunkIndex);
+
+    void buildShadowsOnGPU(std::size_t chunkIndex);
+
+    std::size_t getShadowSeedWordsPerChunk() const;
+
+    void startVisibilityUpdate(std::size_t chunkIndex);
+
+    // Uploads the result of a finished visibility update
     void updateVisibleBlocks(std::size_t chunkIndex);
 
-    VSChunk::VSVisibleBlockInfos chunkUpdateVisibility(
+    static bool isInFrustum(const glm::mat4& VP, const glm::vec3& location, float radius);
+
+    void uploadVisibleBlockInfos(VSChunk* chunk);
+
+    void updateGeometryCounts(VSChunk* chunk) const;
+
+    void uploadMesh(VSChunk* chunk, const std::vector<VSChunk::VSMeshVertex>& meshVertices);
+
+    void ensureQuadIndexCapacity(std::size_t quadCount);
+
+    [[nodiscard]] VSBufferArena* getChunkArena() const;
+
+    void appendDrawCommands(
+        const VSChunk* chunk,
+        std::vector<VSDrawElementsIndirectCommand>& commands) const;
+
+    void setMeshAttribPointers() const;
+
+    void setInstanceAttribPointers(GLuint firstAttribPointer, std::size_t firstInstance) const;
+
+    void drawInstanced(const std::vector<VSChunk*>& visibleChunks);
+
+    void drawMultiDrawIndirect(const std::vector<VSChunk*>& visibleChunks);
+
+    void cullChunksOnGPU(const glm::mat4& VP, const glm::vec3& cameraPos, float zFar, float radius);
+
+    void rebuildCullEntries();
+
+    void drawGPUCulled();
+
+    // Copy of a chunk with a one block apron of its neighbours, taken when a visibility update is
+    // started. The update only reads the snapshot, so it never touches neighbouring chunks that
+    // are edited while it runs and border blocks are looked up like all other blocks.
+    struct VSChunkSnapshot
+    {
+        // chunk size plus the apron on both sides
+        glm::ivec3 size{};
+        // the apron outside of the world is air without light
+        std::vector<VSBlockID> blocks;
+        // packed like the light of VSBlockData::sections
+        std::vector<std::uint8_t> light;
+        // occupancy rows with a row of apron around y and z, empty without occupancy
+        std::vector<std::uint64_t> paddedRows;
+        // occupancy of the apron along x, moved to the bit of the chunk border block
+        std::vector<std::uint64_t> plusXEdges;
+        std::vector<std::uint64_t> minusXEdges;
+        // visibility of the chunk when the update started, partial updates only change the region
+        std::shared_ptr<const VSChunk::VSBlockVisibility> bIsBlockVisible;
+        // Per VSChunkSections section, set if no block of the section can be visible. Either all
+        // blocks are air or all blocks and those around the section are solid.
+        std::vector<bool> bIsSectionHidden;
+
+        [[nodiscard]] bool isSectionHidden(int y) const
+        {
+            return bIsSectionHidden[VSChunkSections::getSectionIndex(y)];
+        }
+
+        [[nodiscard]] std::size_t getIndex(const glm::ivec3& blockCoordinates) const
+        {
+            const auto paddedCoordinates = blockCoordinates + 1;
+            return paddedCoordinates.x + paddedCoordinates.y * size.x +
+                   paddedCoordinates.z * size.x * size.y;
+        }
+    };
+
+    // Frozen block data of a chunk and its neighbours by
+    // (offset x + 1) + (offset y + 1) * 3 + (offset z + 1) * 9, empty outside of the world, and
+    // the visibility of the chunk. Gathered on the main thread, the snapshot is built from it on
+    // the worker.
+    struct VSSnapshotSources
+    {
+        std::array<std::shared_ptr<const VSChunk::VSBlockData>, 27> blockData;
+        std::shared_ptr<const VSChunk::VSBlockVisibility> bIsBlockVisible;
+    };
+
+    VSSnapshotSources getSnapshotSources(std::size_t chunkIndex) const;
+
+    VSChunkSnapshot createChunkSnapshot(const VSSnapshotSources& sources) const;
+
+    VSChunk::VSVisibilityResult chunkUpdateVisibility(
         const std::atomic<bool>& bShouldCancel,
         std::atomic<bool>& bIsReady,
-        std::size_t chunkIndex) const;
+        std::size_t chunkIndex,
+        const VSChunk::VSBlockRegion& region,
+        const VSChunkSnapshot& snapshot) const;
 
-    std::uint8_t isBlockVisible(std::size_t chunkIndex, std::size_t blockIndex) const;
+    // Evaluates only the blocks inside region, see VSVisibilityResult::bIsPartial
+    VSChunk::VSVisibilityResult chunkUpdateVisibleRegion(
+        const std::atomic<bool>& bShouldCancel,
+        std::atomic<bool>& bIsReady,
+        std::size_t chunkIndex,
+        const VSChunk::VSBlockRegion& region,
+        const VSChunkSnapshot& snapshot) const;
+
+    // Replaces the entries of the blocks inside region and uploads only the instances that
+    // changed. Returns false if a face combination outgrew its room, the chunk then has to be
+    // uploaded with uploadVisibleBlockInfos.
+    bool patchVisibleBlockInfos(
+        VSChunk* chunk,
+        const VSChunk::VSBlockRegion& region,
+        const VSChunk::VSVisibleBlockInfos& regionBlockInfos);
+
+    // Seed words covering the blocks from firstBlockIndex to lastBlockIndex
+    std::vector<std::uint32_t> getShadowSeeds(
+        const VSChunkSnapshot& snapshot,
+        const VSChunk::VSBlockVisibility& bIsBlockVisible,
+        std::size_t firstBlockIndex,
+        std::size_t lastBlockIndex) const;
+
+    std::vector<VSChunk::VSMeshVertex> buildGreedyMesh(
+        const std::vector<std::pair<std::size_t, std::uint8_t>>& visibleBlockFaces,
+        const std::vector<std::array<std::uint32_t, 6>>& visibleBlockLights,
+        std::size_t chunkIndex,
+        const VSChunkSnapshot& snapshot) const;
+
+    void uploadChunkLocations();
+
+    std::uint32_t packLocation(std::size_t chunkIndex, const glm::ivec3& blockCoordinates) const;
+
+    glm::ivec3 unpackBlockCoordinates(std::uint32_t packedLocation) const;
+
+    // Averages the corner light of each face down to 4 bits
+    static std::uint32_t packBlock(VSBlockID blockID, const std::array<std::uint32_t, 6>& light);
+
+    // Block index and face combination of all visible blocks, ordered by block index
+    std::vector<std::pair<std::size_t, std::uint8_t>> getVisibleBlockFaces(
+        const std::atomic<bool>& bShouldCancel,
+        std::size_t chunkIndex,
+        const VSChunkSnapshot& snapshot) const;
 
-    std::uint8_t
-    isCenterBlockVisible(std::size_t chunkIndex, const glm::ivec3& blockCoordinates) const;
+    std::vector<std::pair<std::size_t, std::uint8_t>> getVisibleBlockFacesFromOccupancy(
+        std::size_t chunkIndex,
+        const VSChunkSnapshot& snapshot) const;
 
-    std::uint8_t
-    isBorderBlockVisible(std::size_t chunkIndex, const glm::ivec3& blockCoordinates) const;
+    void
+    setOccupancy(VSChunk::VSBlockData* blockData, std::size_t blockIndex, VSBlockID blockID) const;
 
-    bool isAtWorldBorder(const glm::ivec3& blockWorldCoordinates) const;
+    void rebuildOccupancy(VSChunk::VSBlockData* blockData) const;
+
+    std::uint8_t isBlockVisible(
+        const VSChunkSnapshot& snapshot,
+        std::size_t chunkIndex,
+        const glm::ivec3& blockCoordinates) const;
 
-    std::array<std::uint32_t, 6> getLightInformation(const glm::vec3& blockCoordinates) const;
+    bool isAtWorldBorder(const glm::ivec3& blockWorldCoordinates) const;
 
-    std::uint32_t getLightInformationForFace(
-        const glm::vec3& blockWorldCoordinates,
-        const std::array<glm::vec3, 4>& corners) const;
+    // Corner light of all faces from the 3x3x3 blocks around the block, see VSFaceLight
+    std::array<std::uint32_t, 6>
+    getLightInformation(const VSChunkSnapshot& snapshot, const glm::ivec3& blockCoordinates) const;
 
-    std::size_t chunkCoordinatesToChunkIndex(const glm::ivec2& chunkCoordinates) const;
+    std::size_t chunkCoordinatesToChunkIndex(const glm::ivec3& chunkCoordinates) const;
 
-    glm::ivec2 chunkIndexToChunkCoordinates(std::size_t chunkIndex) const;
+    glm::ivec3 chunkIndexToChunkCoordinates(std::size_t chunkIndex) const;
 
     std::size_t blockCoordinatesToBlockIndex(const glm::ivec3& bloockCoords) const;
 
     glm::ivec3 blockIndexToBlockCoordinates(std::size_t blockIndex) const;
 
-    glm::ivec2 worldCoordinatesToChunkCoordinates(const glm::ivec3& worldCoords) const;
+    glm::ivec3 worldCoordinatesToChunkCoordinates(const glm::ivec3& worldCoords) const;
 
     std::tuple<std::size_t, std::size_t>
     worldCoordinatesToChunkAndBlockIndex(const glm::ivec3& worldCoords) const;
 
-    std::tuple<glm::ivec2, std::size_t>
+    std::tuple<glm::ivec3, std::size_t>
     worldCoordinatesToChunkCoordinatesAndBlockIndex(const glm::ivec3& worldCoords) const;
 
     glm::ivec3
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+// Memory of the chunks of one world. Blocks, light, occupancy and visibility of all chunks come
+// from pools carved out of a few large cache line aligned blocks, buffers freed by one chunk are
+// handed to the next buffer of the same size instead of going back to the heap. Everything is
+// returned at once when the world's chunk manager goes away. Safe to use from any thread.
+class VSChunkMemory
+{
+public:
+    // VS_CHUNK_HUGE_PAGES is set by the CMake option of the same name, the blocks are then aligned
+    // to and advised as 2 MiB pages where the system supports it
+    VSChunkMemory();
+
+    VSChunkMemory(const VSChunkMemory&) = delete;
+
+    VSChunkMemory& operator=(const VSChunkMemory&) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource* getResource() const
+    {
+        return &pools;
+    }
+
+    // bytes taken from the heap so far
+    [[nodiscard]] std::size_t getReservedBytes() const;
+
+private:
+    // Hands out the memory of the pools from large blocks one after the other. Memory is only
+    // returned with the whole resource, allocations too large to share a block get their own.
+    class VSBlockResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit VSBlockResource(bool bShouldUseHugePages);
+
+        VSBlockResource(const VSBlockResource&) = delete;
+
+        VSBlockResource& operator=(const VSBlockResource&) = delete;
+
+        ~VSBlockResource() override;
+
+        [[nodiscard]] std::size_t getReservedBytes() const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const
+            noexcept override;
+
+    private:
+        struct VSBlock
+        {
+            std::byte* data = nullptr;
+            std::size_t size = 0;
+            std::size_t alignment = 0;
+        };
+
+        [[nodiscard]] std::size_t getBlockAlignment(std::size_t size) const;
+
+        [[nodiscard]] VSBlock allocateBlock(std::size_t size, std::size_t alignment) const;
+
+        void freeBlock(const VSBlock& block) const;
+
+        bool bShouldUseHugePages;
+
+        mutable std::mutex mutex;
+
+        // shared blocks, the last one is filled next
+        std::vector<VSBlock> blocks;
+
+        std::size_t nextOffset = 0;
+
+        std::size_t reservedBytes = 0;
+    };
+
+    static constexpr std::size_t cacheLineSize = 64;
+
+    static constexpr std::size_t hugePageSize = std::size_t{2} << 20;
+
+    static constexpr std::size_t blockSize = std::size_t{4} << 20;
+
+    // larger buffers, like the blocks of very large chunks, go to the block resource directly
+    static constexpr std::size_t largestPooledSize = std::size_t{1} << 20;
+
+    VSBlockResource blockResource;
+
+    // not const so getResource can be called on a const chunk manager, the pools lock themselves
+    mutable std::pmr::synchronized_pool_resource pools;
+};
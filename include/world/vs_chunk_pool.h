@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Chunks of a world side by side in as few allocations as possible. Chunks are constructed once
+// and live as long as the pool, setting up a world again resets them in place together with the
+// buffers they own. Growing adds an allocation for the missing chunks, existing chunks never move.
+template <typename Chunk>
+class VSChunkPool
+{
+public:
+    static constexpr std::size_t cacheLineSize = 64;
+
+    // neighbouring chunks are changed by different threads
+    static_assert(alignof(Chunk) % cacheLineSize == 0, "Chunks have to start on a cache line");
+
+    VSChunkPool() = default;
+
+    VSChunkPool(const VSChunkPool&) = delete;
+
+    VSChunkPool& operator=(const VSChunkPool&) = delete;
+
+    ~VSChunkPool()
+    {
+        for (const auto& allocation : allocations)
+        {
+            for (std::size_t chunkIndex = 0; chunkIndex < allocation.chunkCount; chunkIndex++)
+            {
+                allocation.chunks[chunkIndex].~Chunk();
+            }
+            ::operator delete(allocation.chunks, std::align_val_t{alignof(Chunk)});
+        }
+    }
+
+    // Uses the first count chunks, chunks past them are kept for a larger world later on and
+    // missing ones are value initialized
+    void resize(std::size_t count)
+    {
+        if (count > capacity)
+        {
+            VSAllocation allocation;
+            allocation.chunkCount = count - capacity;
+            allocation.chunks = static_cast<Chunk*>(::operator new(
+                allocation.chunkCount * sizeof(Chunk), std::align_val_t{alignof(Chunk)}));
+            for (std::size_t chunkIndex = 0; chunkIndex < allocation.chunkCount; chunkIndex++)
+            {
+                new (allocation.chunks + chunkIndex) Chunk();
+            }
+            allocations.push_back(allocation);
+            capacity = count;
+        }
+        chunkCount = count;
+    }
+
+    [[nodiscard]] Chunk* get(std::size_t chunkIndex) const
+    {
+        for (const auto& allocation : allocations)
+        {
+            if (chunkIndex < allocation.chunkCount)
+            {
+                return allocation.chunks + chunkIndex;
+            }
+            chunkIndex -= allocation.chunkCount;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return chunkCount;
+    }
+
+private:
+    struct VSAllocation
+    {
+        Chunk* chunks = nullptr;
+        std::size_t chunkCount = 0;
+    };
+
+    // in order of the chunk indices they hold
+    std::vector<VSAllocation> allocations;
+
+    std::size_t chunkCount = 0;
+
+    std::size_t capacity = 0;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Chunks waiting for a rebuild, handed out in priority order.
+// A chunk is queued at most once and keeps the time it was queued first.
+class VSChunkRebuildQueue
+{
+public:
+    // Returns the priority of a chunk given how long it waited, lower values are rebuilt first
+    using VSPriorityFunction = std::function<float(std::size_t chunkIndex, float waitSeconds)>;
+
+    void push(std::size_t chunkIndex);
+
+    // Recomputes the order of all queued chunks, chunks pushed afterwards are only handed out
+    // after the next call
+    void prioritize(const VSPriorityFunction& getPriority);
+
+    // Returns false if no prioritized chunk is left
+    bool pop(std::size_t& chunkIndex);
+
+    void clear();
+
+    [[nodiscard]] std::size_t size() const;
+
+    // Moving average of the time between push and pop
+    [[nodiscard]] float getAverageWaitSeconds() const;
+
+private:
+    using VSClock = std::chrono::steady_clock;
+
+    // priority and chunk index, smallest priority on top
+    using VSEntry = std::pair<float, std::size_t>;
+
+    std::unordered_map<std::size_t, VSClock::time_point> queuedSince;
+
+    std::priority_queue<VSEntry, std::vector<VSEntry>, std::greater<>> order;
+
+    float averageWaitSeconds = 0.F;
+
+    static constexpr float averageWaitWeight = 0.05F;
+};
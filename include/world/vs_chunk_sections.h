@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <memory_resource>
+#include <vector>
+
+#include "world/vs_block.h"
+#include "world/vs_block_layout.h"
+#include "world/vs_paletted_blocks.h"
+
+// Blocks and light of a chunk split into sections of sectionHeight layers along y. Sections store
+// a single value as soon as all their blocks or all their light are the same. Blocks are addressed
+// by their index in the chunk, x + y * size.x + z * size.x * size.y, BlockLayout decides the order
+// they are stored in inside a section. All buffers come from the memory resource given on
+// construction.
+template <typename BlockLayout>
+class VSBasicChunkSections
+{
+public:
+    static constexpr int sectionHeight = 16;
+
+    VSBasicChunkSections() = default;
+
+    // no sections until reset
+    explicit VSBasicChunkSections(std::pmr::memory_resource* memory);
+
+    // all blocks are air with light
+    VSBasicChunkSections(
+        const glm::ivec3& chunkSize,
+        std::uint8_t light,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    VSBasicChunkSections(const VSBasicChunkSections& other);
+
+    VSBasicChunkSections(VSBasicChunkSections&& other) = default;
+
+    VSBasicChunkSections& operator=(const VSBasicChunkSections& other) = default;
+
+    VSBasicChunkSections& operator=(VSBasicChunkSections&& other) = default;
+
+    // All blocks become air with light. Sections of a chunk of the same size are reset in place
+    // and keep the capacity of their buffers.
+    void reset(const glm::ivec3& chunkSize, std::uint8_t light);
+
+    [[nodiscard]] static std::size_t getSectionIndex(int y)
+    {
+        return static_cast<std::size_t>(y / sectionHeight);
+    }
+
+    [[nodiscard]] std::size_t getSectionCount() const
+    {
+        return sections.size();
+    }
+
+    [[nodiscard]] std::size_t getBlockCount() const
+    {
+        return static_cast<std::size_t>(size.x) * size.y * size.z;
+    }
+
+    [[nodiscard]] VSBlockID getBlock(std::size_t blockIndex) const
+    {
+        const auto location = locate(blockIndex);
+        return sections[location.sectionIndex].blocks.get(location.sectionBlockIndex);
+    }
+
+    void setBlock(std::size_t blockIndex, VSBlockID blockID);
+
+    [[nodiscard]] std::uint8_t getLight(std::size_t blockIndex) const
+    {
+        const auto location = locate(blockIndex);
+        const auto& section = sections[location.sectionIndex];
+        return section.light.empty() ? section.uniformLight
+                                     : section.light[location.sectionBlockIndex];
+    }
+
+    void setLight(std::size_t blockIndex, std::uint8_t light);
+
+    // All blocks of the section are the same, see getSectionBlock
+    [[nodiscard]] bool isSectionUniform(std::size_t sectionIndex) const
+    {
+        return sections[sectionIndex].blocks.isUniform();
+    }
+
+    // block at the bottom of the section, the block of the whole section if it is uniform
+    [[nodiscard]] VSBlockID getSectionBlock(std::size_t sectionIndex) const
+    {
+        return sections[sectionIndex].blocks.get(0);
+    }
+
+    void setSectionLight(std::size_t sectionIndex, std::uint8_t light);
+
+    // Replaces all blocks with getBlockCount() ids from source, ordered by block index
+    void assignBlocks(const VSBlockID* source);
+
+    // Decodes count blocks of the row along x starting at blockIndex into target
+    void copyRowBlocks(std::size_t blockIndex, std::size_t count, VSBlockID* target) const;
+
+    void copyRowLight(std::size_t blockIndex, std::size_t count, std::uint8_t* target) const;
+
+    // Shrinks the blocks of sections that use fewer ids than they did
+    void compact();
+
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+
+private:
+    struct VSSection
+    {
+        explicit VSSection(std::pmr::memory_resource* memory)
+            : blocks(memory), light(memory), lightCounts(memory)
+        {
+        }
+
+        // copies keep the memory resource of the original
+        VSSection(const VSSection& other)
+            : layout(other.layout),
+              blocks(other.blocks),
+              light(other.light, other.light.get_allocator()),
+              lightCounts(other.lightCounts, other.lightCounts.get_allocator()),
+              uniformLight(other.uniformLight)
+        {
+        }
+
+        VSSection(VSSection&& other) = default;
+
+        VSSection& operator=(const VSSection& other) = default;
+
+        VSSection& operator=(VSSection&& other) = default;
+
+        BlockLayout layout;
+        VSPalettedBlocks blocks;
+        // empty if all blocks have uniformLight
+        std::pmr::vector<std::uint8_t> light;
+        // blocks per light value, only kept while light is filled
+        std::pmr::vector<std::uint32_t> lightCounts;
+        std::uint8_t uniformLight = 0;
+    };
+
+    struct VSSectionLocation
+    {
+        std::size_t sectionIndex;
+        // index of the block in the layout of the section
+        std::size_t sectionBlockIndex;
+        // y relative to the section
+        glm::ivec3 sectionCoordinates;
+    };
+
+    [[nodiscard]] VSSectionLocation locate(std::size_t blockIndex) const
+    {
+        const auto width = static_cast<std::size_t>(size.x);
+        const auto height = static_cast<std::size_t>(size.y);
+        const auto row = blockIndex / width;
+        const auto z = row / height;
+        const auto y = row - z * height;
+        const auto sectionIndex = y / sectionHeight;
+        const auto sectionCoordinates = glm::ivec3(
+            blockIndex - row * width, y - sectionIndex * sectionHeight, z);
+        return {
+            sectionIndex,
+            sections[sectionIndex].layout.getIndex(sectionCoordinates),
+            sectionCoordinates};
+    }
+
+    // the top section is lower if the chunk height is not a multiple of sectionHeight
+    [[nodiscard]] std::size_t getSectionHeight(std::size_t sectionIndex) const
+    {
+        return sectionIndex + 1 < sections.size()
+                   ? std::size_t{sectionHeight}
+                   : static_cast<std::size_t>(size.y) - sectionIndex * sectionHeight;
+    }
+
+    std::pmr::vector<VSSection> sections;
+
+    glm::ivec3 size{};
+};
+
+// VS_TILED_BLOCK_LAYOUT is set by the CMake option of the same name. The layout only orders the
+// storage inside the sections: meshing, lighting, the distance transform and saving keep walking
+// linear chunk block indices, which are translated on every access.
+#ifdef VS_TILED_BLOCK_LAYOUT
+using VSChunkSections = VSBasicChunkSections<VSTiledBlockLayout>;
+#else
+using VSChunkSections = VSBasicChunkSections<VSLinearBlockLayout>;
+#endif
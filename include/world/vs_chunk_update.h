@@ -1,32 +1,47 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <functional>
 #include <future>
+#include <vector>
+
+#include "core/vs_app.h"
+#include "core/vs_thread_pool.h"
 
 template <typename Result>
 class VSChunkUpdate
 {
 public:
+    // generation is the chunk generation the update starts from, see VSChunk::generation
     static std::shared_ptr<VSChunkUpdate<Result>> create(
         std::function<Result(const std::atomic<bool>&, std::atomic<bool>&, std::size_t chunkIndex)>
             updateFunction,
-        std::size_t chunkIndex)
+        std::size_t chunkIndex,
+        std::uint32_t generation)
     {
         const auto chunkUpdate = std::shared_ptr<VSChunkUpdate>(new VSChunkUpdate);
-        chunkUpdate->result = std::async(
-            std::launch::async,
-            updateFunction,
-            std::ref(chunkUpdate->bShouldCancel),
-            std::ref(chunkUpdate->bIsReady),
-            chunkIndex);
+        chunkUpdate->generation = generation;
+        // the task keeps the update alive until it ran, even if it is dropped earlier
+        chunkUpdate->result = VSApp::getInstance()->getThreadPool()->submit(
+            [updateFunction, chunkUpdate, chunkIndex]() {
+                return updateFunction(
+                    chunkUpdate->bShouldCancel, chunkUpdate->bIsReady, chunkIndex);
+            });
 
         return chunkUpdate;
     };
 
+    // Only asks the update to stop, use wait() if the chunk data is about to go away
     void cancel()
     {
         bShouldCancel = true;
+    };
+
+    void wait()
+    {
         if (result.valid())
         {
             result.wait();
@@ -38,6 +53,18 @@ public:
         return bIsReady;
     };
 
+    // True once the task returned, also if it was canceled
+    bool isFinished()
+    {
+        return !result.valid() ||
+               result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+
+    [[nodiscard]] std::uint32_t getGeneration() const
+    {
+        return generation;
+    };
+
     Result getResult()
     {
         return result.get();
@@ -51,5 +78,106 @@ private:
 
     std::atomic<bool> bHasStarted = false;
 
+    std::uint32_t generation = 0;
+
     std::future<Result> result;
-};
\ No newline at end of file
+};
+
+// Running updates indexed by chunk
+template <typename Result>
+class VSChunkUpdateTable
+{
+public:
+    using VSUpdate = VSChunkUpdate<Result>;
+
+    void resize(std::size_t chunkCount)
+    {
+        updates.assign(chunkCount, nullptr);
+        chunkIndices.clear();
+    };
+
+    // Number of running updates
+    [[nodiscard]] std::size_t size() const
+    {
+        return chunkIndices.size();
+    };
+
+    // Chunks with a running update
+    [[nodiscard]] const std::vector<std::size_t>& getChunkIndices() const
+    {
+        return chunkIndices;
+    };
+
+    [[nodiscard]] const std::shared_ptr<VSUpdate>& get(std::size_t chunkIndex) const
+    {
+        return updates[chunkIndex];
+    };
+
+    // Replaces the running update of the chunk, the old one is abandoned
+    void add(std::size_t chunkIndex, std::shared_ptr<VSUpdate> update)
+    {
+        abandon(chunkIndex);
+        updates[chunkIndex] = std::move(update);
+        chunkIndices.push_back(chunkIndex);
+    };
+
+    void remove(std::size_t chunkIndex)
+    {
+        if (!updates[chunkIndex])
+        {
+            return;
+        }
+
+        updates[chunkIndex].reset();
+        // only a few updates run at a time
+        const auto position = std::find(chunkIndices.begin(), chunkIndices.end(), chunkIndex);
+        *position = chunkIndices.back();
+        chunkIndices.pop_back();
+    };
+
+    // Cancels the running update of the chunk without waiting for it
+    void abandon(std::size_t chunkIndex)
+    {
+        if (!updates[chunkIndex])
+        {
+            return;
+        }
+
+        updates[chunkIndex]->cancel();
+        abandonedUpdates.push_back(updates[chunkIndex]);
+        remove(chunkIndex);
+    };
+
+    void removeFinishedAbandonedUpdates()
+    {
+        abandonedUpdates.erase(
+            std::remove_if(
+                abandonedUpdates.begin(),
+                abandonedUpdates.end(),
+                [](const std::shared_ptr<VSUpdate>& update) { return update->isFinished(); }),
+            abandonedUpdates.end());
+    };
+
+    // Cancels all updates and waits for them, needed before the chunks are deleted
+    void cancelAndWait()
+    {
+        while (!chunkIndices.empty())
+        {
+            abandon(chunkIndices.back());
+        }
+
+        for (const auto& update : abandonedUpdates)
+        {
+            update->wait();
+        }
+        abandonedUpdates.clear();
+    };
+
+private:
+    std::vector<std::shared_ptr<VSUpdate>> updates;
+
+    std::vector<std::size_t> chunkIndices;
+
+    // canceled updates that may still be running
+    std::vector<std::shared_ptr<VSUpdate>> abandonedUpdates;
+};
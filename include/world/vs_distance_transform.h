@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <vector>
+
+// Exact squared euclidean distance transform in linear time (Felzenszwalb and Huttenlocher).
+struct VSDistanceTransform
+{
+    // Value of cells without a feature, large enough to never be picked but still finite
+    static constexpr float infinity = 1e20F;
+
+    // grid holds 0 for feature cells and infinity for all others, indexed by
+    // x + y * size.x + z * size.x * size.y. Afterwards each cell holds the squared distance to
+    // the closest feature cell.
+    void compute(std::vector<float>& grid, const glm::ivec3& size);
+
+private:
+    // scratch buffers reused between lines
+    std::vector<float> line;
+    std::vector<float> lineDistances;
+    std::vector<int> parabolaVertices;
+    std::vector<float> parabolaBounds;
+
+    void transformAxis(std::vector<float>& grid, const glm::ivec3& size, int axis);
+
+    void transformLine(int count);
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Corner light of all faces of a block from the light around it.
+// A sample is the light of one block in 1/15 light value steps, solid blocks have 0.
+struct VSFaceLight
+{
+    // light value 32 on all 4 samples of a corner is full brightness
+    static constexpr std::uint16_t maxCornerSampleSum = 4 * 32 * 15;
+
+    // samples holds the 3x3x3 blocks centered on the block, indexed by x + 3 * y + 9 * z.
+    // Returns one 8 bit light per corner and face, in the face order right, left, top, bottom,
+    // front, back. Corner bytes are indexed by u + 2 * v, with u and v the two axes along the face
+    // in x, y, z order.
+    static std::array<std::uint32_t, 6> gather(const std::array<std::uint16_t, 27>& samples);
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Face exposure of whole block rows using packed occupancy bits.
+// A row holds up to 64 blocks along x, bit x is set if block x is not air.
+struct VSFaceMasks
+{
+    // Bit x of a mask is set if that face of block x borders air
+    std::vector<std::uint64_t> right;
+    std::vector<std::uint64_t> left;
+    std::vector<std::uint64_t> top;
+    std::vector<std::uint64_t> bottom;
+    std::vector<std::uint64_t> front;
+    std::vector<std::uint64_t> back;
+
+    // paddedRows holds (rowCountY + 2) * (rowCountZ + 2) rows, including one row of neighbours on
+    // each side. Row (y, z) is stored at (y + 1) + (z + 1) * (rowCountY + 2).
+    // plusXEdges and minusXEdges hold the occupancy of the blocks next to the first and last block
+    // of each row, already moved to the bit of the block they border.
+    // Results are indexed by y + z * rowCountY.
+    void compute(
+        const std::uint64_t* paddedRows,
+        const std::uint64_t* plusXEdges,
+        const std::uint64_t* minusXEdges,
+        int rowCountY,
+        int rowCountZ);
+
+    // Index of the lowest set bit, bits must not be 0
+    static int countTrailingZeros(std::uint64_t bits);
+};
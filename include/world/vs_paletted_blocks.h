@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "world/vs_block.h"
+
+// Block ids stored as indices into a palette of the ids in use, packed with 1, 2, 4 or 8 bits
+// per block. Blocks that become uniform only keep their single id. Adding an id to a full palette
+// repacks the blocks with the next larger index size. All buffers come from the memory resource
+// given on construction, copies keep using the resource of the original.
+class VSPalettedBlocks
+{
+public:
+    VSPalettedBlocks() = default;
+
+    explicit VSPalettedBlocks(std::pmr::memory_resource* memory);
+
+    explicit VSPalettedBlocks(
+        std::size_t blockCount,
+        VSBlockID blockID = VS_DEFAULT_BLOCK_ID,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    VSPalettedBlocks(const VSPalettedBlocks& other);
+
+    VSPalettedBlocks(VSPalettedBlocks&& other) = default;
+
+    VSPalettedBlocks& operator=(const VSPalettedBlocks& other) = default;
+
+    VSPalettedBlocks& operator=(VSPalettedBlocks&& other) = default;
+
+    // All blocks become blockID, the buffers keep their capacity
+    void reset(std::size_t blockCountToSet, VSBlockID blockID);
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return blockCount;
+    }
+
+    [[nodiscard]] VSBlockID get(std::size_t blockIndex) const
+    {
+        return palette[getPaletteIndex(blockIndex)];
+    }
+
+    void set(std::size_t blockIndex, VSBlockID blockID);
+
+    [[nodiscard]] bool isUniform() const
+    {
+        return palette.size() == 1;
+    }
+
+    // Replaces all blocks with size() ids from source
+    void assign(const VSBlockID* source);
+
+    // Decodes count blocks from blockIndex on into target
+    void copyTo(std::size_t blockIndex, std::size_t count, VSBlockID* target) const;
+
+    // Repacks with a smaller index size if the ids still in use fit
+    void compact();
+
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+
+private:
+    // Packs source with the smallest index size that has room for the ids in use and
+    // reservedPaletteEntries more
+    void pack(const VSBlockID* source, std::size_t reservedPaletteEntries);
+
+    [[nodiscard]] std::size_t getPaletteIndex(std::size_t blockIndex) const
+    {
+        // indices never straddle two words since the index size divides 64, uniform blocks
+        // always read the first word and index
+        const auto bitIndex = blockIndex * bitsPerBlock;
+        return (words[bitIndex / 64] >> (bitIndex % 64)) & paletteIndexMask;
+    }
+
+    void setPaletteIndex(std::size_t blockIndex, std::uint64_t paletteIndex);
+
+    std::pmr::vector<VSBlockID> palette;
+
+    // blocks per palette entry, entries without blocks are reused for new ids
+    std::pmr::vector<std::uint32_t> paletteCounts;
+
+    std::pmr::vector<std::uint64_t> words;
+
+    std::size_t blockCount = 0;
+
+    std::uint8_t bitsPerBlock = 0;
+
+    std::uint64_t paletteIndexMask = 0;
+};
@@ -20,7 +20,15 @@ uniform uvec3 worldSize;
 uniform vec3 colorOverride;
 
 uniform sampler2DArray spriteTexture;
+// brick pool and the brick table pointing into it
 uniform sampler3D shadowTexture;
+uniform sampler3D shadowBrickTable;
+uniform int shadowBrickSize;
+// distances at the limit only say that nothing is closer
+uniform float shadowDistanceLimit;
+
+// same as the border of the old full world texture
+const float maxShadowDistance = 3.402823466e+38;
 
 uniform bool enableShadows;
 uniform bool enableAO;
@@ -34,15 +42,25 @@ uniform float time;
 vec3 worldSizeHalf = worldSize / 2u;
 
 float map(in vec3 pos) {
-    vec3 shadowTexCoord = (pos + worldSizeHalf) / vec3(worldSize);
-    float distance = texture(shadowTexture, shadowTexCoord).r;
-    //float distance = texelFetch(shadowTexture, clamp(ivec3(pos + worldSizeHalf), ivec3(0.0), ivec3(worldSize) - ivec3(1.0)), 0).r;
-    return distance;
+    // texel centers at integer coordinates
+    vec3 texel = pos + worldSizeHalf - 0.5;
+    ivec3 brick = ivec3(floor(texel / float(shadowBrickSize)));
+    if (any(lessThan(brick, ivec3(0))) ||
+        any(greaterThanEqual(brick, textureSize(shadowBrickTable, 0)))) {
+        return maxShadowDistance;
+    }
 
+    vec4 brickEntry = texelFetch(shadowBrickTable, brick, 0);
+    vec3 local = texel - vec3(brick * shadowBrickSize);
 
-    // ivec3 shadowTexCoord = clamp(ivec3(pos + worldSizeHalf), ivec3(0.0), ivec3(worldSize) - ivec3(1.0));
-    //float distance = texelFetch(shadowTexture, shadowTexCoord, 0).r);
-    //return float(distance -1.0 - min(sdBox(pos - ivec3(pos) + 0.5), -0.999);
+    // bricks without a page only know their smallest distance and the distance at their center
+    if (brickEntry.x < 0.0) {
+        vec3 center = vec3(shadowBrickSize / 2);
+        return max(brickEntry.w, brickEntry.y - length(local - center));
+    }
+
+    vec3 poolTexel = brickEntry.xyz * float(shadowBrickSize + 1) + local + 0.5;
+    return texture(shadowTexture, poolTexel / vec3(textureSize(shadowTexture, 0))).r;
 }
 
 // https://www.shadertoy.com/view/lsKcDD
@@ -61,8 +79,11 @@ float raymarch(in vec3 ro, in vec3 rd) {
     for(int i=0; i < maxSteps; i++)
     {
         float h = map(ro + rd * t);
-        float s = clamp(softness*h/t,0.0,1.0);
-        res = min(res, s*s*(3.0-2.0*s));
+        // capped distances would darken steps far along the ray
+        if (h < shadowDistanceLimit) {
+            float s = clamp(softness*h/t,0.0,1.0);
+            res = min(res, s*s*(3.0-2.0*s));
+        }
 
         t += h;
 
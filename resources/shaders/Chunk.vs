@@ -3,16 +3,20 @@
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inNormal;
 
-layout (location = 2) in vec3 blockLocation;
+#ifdef VS_GREEDY_MESHING
+// merged quads are already in world space and carry their light per vertex
+layout (location = 2) in uint blockID;
+layout (location = 3) in float inLightLevel;
+#else
+// see VSVisibleBlockInfo
+layout (location = 2) in uint packedLocation;
+layout (location = 3) in uint packedBlock;
 
-layout (location = 3) in uint blockID;
-
-layout (location = 4) in uint lightRight;
-layout (location = 5) in uint lightLeft;
-layout (location = 6) in uint lightTop;
-layout (location = 7) in uint lightBottom;
-layout (location = 8) in uint lightFront;
-layout (location = 9) in uint lightBack;
+// chunk centers indexed by the chunk index inside packedLocation
+uniform samplerBuffer chunkLocations;
+uniform vec3 chunkSize;
+uniform uvec3 locationBitCounts;
+#endif
 
 uniform vec3[7] blockColors;
 
@@ -29,85 +33,63 @@ out VertexData {
 
 uniform mat4 VP;
 
-uint getByte(in uint num, in uint n)
+#ifndef VS_GREEDY_MESHING
+uint getBits(in uint word, in uint offset, in uint count)
 {
-    return (num & (0x000000FFu << (n * 8u))) >> (n * 8u);
+    return (word >> offset) & ((1u << count) - 1u);
 }
 
-float getLight(in vec3 faceNormal, inout vec3 vertexPos, inout vec2 texCoord)
+vec3 getBlockLocation()
 {
-    float lightLevelDeNorm = 0.0;
-    if (faceNormal.x == 1) {
-        if (getByte(lightRight, 0u) + getByte(lightRight, 3u) > getByte(lightRight, 1u) + getByte(lightRight, 2u)) {
-            float y = vertexPos.y;
-            vertexPos.y = vertexPos.z;
-            vertexPos.z = -y;
-        }
-        texCoord.x = vertexPos.z + 0.5;
-        texCoord.y = vertexPos.y + 0.5;
-        lightLevelDeNorm = getByte(lightRight, uint((vertexPos.y + 0.5) * 1 + (vertexPos.z + 0.5) * 2));
-    }
-    if (faceNormal.x == -1) {
-        if (getByte(lightLeft, 0u) + getByte(lightLeft, 3u) > getByte(lightLeft, 1u) + getByte(lightLeft, 2u)) {
-            float y = vertexPos.y;
-            vertexPos.y = vertexPos.z;
-            vertexPos.z = -y;
-        }
-        texCoord.x = vertexPos.z + 0.5;
-        texCoord.y = vertexPos.y + 0.5;
-        lightLevelDeNorm = getByte(lightLeft, uint((vertexPos.y + 0.5) * 1 + (vertexPos.z + 0.5) * 2));
-    }
-    if (faceNormal.y == 1) {
-        if (getByte(lightTop, 0u) + getByte(lightTop, 3u) > getByte(lightTop, 1u) + getByte(lightTop, 2u)) {
-            float x = vertexPos.x;
-            vertexPos.x = vertexPos.z;
-            vertexPos.z = -x;
-        }
-        texCoord.x = vertexPos.x + 0.5;
-        texCoord.y = vertexPos.z + 0.5;
-        lightLevelDeNorm = getByte(lightTop, uint((vertexPos.x + 0.5) * 1 + (vertexPos.z + 0.5) * 2));
-    }
-    if (faceNormal.y == -1) {
-        if (getByte(lightBottom, 0u) + getByte(lightBottom, 3u) > getByte(lightBottom, 1u) + getByte(lightBottom, 2u)) {
-            float x = vertexPos.x;
-            vertexPos.x = vertexPos.z;
-            vertexPos.z = -x;
-        }
-        texCoord.x = vertexPos.x + 0.5;
-        texCoord.y = vertexPos.z + 0.5;
-        lightLevelDeNorm = getByte(lightBottom, uint((vertexPos.x + 0.5) * 1 + (vertexPos.z + 0.5) * 2));
-    }
-    if (faceNormal.z == 1) {
-        if (getByte(lightFront, 0u) + getByte(lightFront, 3u) > getByte(lightFront, 1u) + getByte(lightFront, 2u)) {
-            float x = vertexPos.x;
-            vertexPos.x = vertexPos.y;
-            vertexPos.y = -x;
-        }
-        texCoord.x = vertexPos.x + 0.5;
-        texCoord.y = vertexPos.y + 0.5;
-        lightLevelDeNorm = getByte(lightFront, uint((vertexPos.x + 0.5) * 1 + (vertexPos.y + 0.5) * 2));
+    uvec3 blockCoordinates = uvec3(
+        getBits(packedLocation, 0u, locationBitCounts.x),
+        getBits(packedLocation, locationBitCounts.x, locationBitCounts.y),
+        getBits(packedLocation, locationBitCounts.x + locationBitCounts.y, locationBitCounts.z));
+    uint chunkIndex =
+        packedLocation >> (locationBitCounts.x + locationBitCounts.y + locationBitCounts.z);
+
+    vec3 chunkLocation = texelFetch(chunkLocations, int(chunkIndex)).xyz;
+    return chunkLocation - chunkSize / 2.0 + vec3(blockCoordinates) + 0.5;
+}
+
+float getLight(in vec3 faceNormal, in vec3 vertexPos, out vec2 texCoord)
+{
+    // same order as the light nibbles in packedBlock
+    uint face = faceNormal.x == 1 ? 0u : 1u;
+    texCoord = vertexPos.zy + 0.5;
+    if (faceNormal.y != 0) {
+        face = faceNormal.y == 1 ? 2u : 3u;
+        texCoord = vertexPos.xz + 0.5;
     }
-    if (faceNormal.z == -1) {
-        if (getByte(lightBack, 0u) + getByte(lightBack, 3u) > getByte(lightBack, 1u) + getByte(lightBack, 2u)) {
-            float x = vertexPos.x;
-            vertexPos.x = vertexPos.y;
-            vertexPos.y = -x;
-        }
-        texCoord.x = vertexPos.x + 0.5;
-        texCoord.y = vertexPos.y + 0.5;
-        lightLevelDeNorm = getByte(lightBack, uint((vertexPos.x + 0.5) * 1 + (vertexPos.y + 0.5) * 2));
+    if (faceNormal.z != 0) {
+        face = faceNormal.z == 1 ? 4u : 5u;
+        texCoord = vertexPos.xy + 0.5;
     }
-    return lightLevelDeNorm / 255.0;
+    return float(getBits(packedBlock, 8u + face * 4u, 4u)) / 15.0;
 }
+#endif
 
 void main()
 {
-    // getLight might require us to flip teh quad
-    vec3 vertexPosition = inPosition;
+#ifdef VS_GREEDY_MESHING
+    // block corners are at integer positions, so the sprite texture repeats once per block
+    vec2 texCoord = inPosition.xy;
+    if (inNormal.x != 0) {
+        texCoord = inPosition.zy;
+    }
+    if (inNormal.y != 0) {
+        texCoord = inPosition.xz;
+    }
+    float lightLevel = inLightLevel;
+
+    o.worldPosition = origin + inPosition;
+#else
+    uint blockID = getBits(packedBlock, 0u, 8u);
     vec2 texCoord = vec2(0);
-    float lightLevel = getLight(inNormal, vertexPosition, texCoord);
+    float lightLevel = getLight(inNormal, inPosition, texCoord);
 
-    o.worldPosition = origin + vec3(blockLocation + vertexPosition);
+    o.worldPosition = origin + getBlockLocation() + inPosition;
+#endif
     o.normal = inNormal;
     o.texCoord = texCoord;
     o.material = blockColors[blockID];
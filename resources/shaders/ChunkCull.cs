@@ -0,0 +1,73 @@
+#version 430 core
+
+layout (local_size_x = 64) in;
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+// one entry per chunk and face combination
+struct CullEntry {
+    DrawCommand command;
+    uint chunkIndex;
+};
+
+layout (std430, binding = 0) readonly buffer ChunkLocations {
+    vec4 chunkLocations[];
+};
+
+layout (std430, binding = 1) readonly buffer CullEntries {
+    CullEntry cullEntries[];
+};
+
+layout (std430, binding = 2) writeonly buffer DrawCommands {
+    DrawCommand drawCommands[];
+};
+
+layout (std430, binding = 3) buffer DrawCommandCount {
+    uint drawCommandCount;
+};
+
+uniform mat4 VP;
+uniform vec3 cameraPos;
+uniform float zFar;
+uniform float radius;
+uniform bool enableFrustumCulling;
+uniform int cullEntryCount;
+
+bool isChunkVisible(in vec3 chunkLocation)
+{
+    // cheap distance check based on zFar
+    vec3 cameraToChunk = cameraPos - chunkLocation;
+    if (dot(cameraToChunk, cameraToChunk) - (radius * radius * 4.0) >= zFar * zFar) {
+        return false;
+    }
+
+    if (!enableFrustumCulling) {
+        return true;
+    }
+
+    // bounding sphere in projection space
+    vec4 chunkCenterInP = VP * vec4(chunkLocation, 1.0);
+    return (abs(chunkCenterInP.x) - radius) < chunkCenterInP.w &&
+           (abs(chunkCenterInP.y) - radius) < chunkCenterInP.w;
+}
+
+void main()
+{
+    int entryIndex = int(gl_GlobalInvocationID.x);
+    if (entryIndex >= cullEntryCount) {
+        return;
+    }
+
+    CullEntry entry = cullEntries[entryIndex];
+    if (isChunkVisible(chunkLocations[entry.chunkIndex].xyz)) {
+        // compact visible commands to the front, drawCommandCount is the draw count on GL 4.6
+        // and without it the rest of the buffer stays zeroed
+        drawCommands[atomicAdd(drawCommandCount, 1u)] = entry.command;
+    }
+}
@@ -0,0 +1,257 @@
+#version 430 core
+
+layout (local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// 2 bits per block of every chunk, bit 0 = visible, bit 1 = solid
+layout (std430, binding = 0) readonly buffer ShadowSeeds {
+    uint shadowSeeds[];
+};
+
+// packed region coordinates of the closest visible block per region block
+layout (std430, binding = 1) readonly buffer InputSeeds {
+    uint inputSeeds[];
+};
+
+layout (std430, binding = 2) writeonly buffer OutputSeeds {
+    uint outputSeeds[];
+};
+
+// page of each brick of the chunk, -1 if the brick has none
+layout (std430, binding = 3) readonly buffer BrickPages {
+    int brickPages[];
+};
+
+// ordered minimum and center distance of each brick of the chunk
+layout (std430, binding = 4) buffer BrickDistances {
+    uint brickDistances[];
+};
+
+layout (r16f, binding = 0) uniform writeonly image3D shadowBrickPool;
+layout (rgba16f, binding = 1) uniform writeonly image3D shadowBrickTable;
+
+const int stageInit = 0;
+const int stageStep = 1;
+const int stageResolve = 2;
+const int stageBrickTable = 3;
+
+const uint unsetDistance = 0xFFFFFFFFu;
+
+const uint invalidSeed = 0xFFFFFFFFu;
+
+uniform int stage;
+uniform int stepSize;
+
+uniform ivec3 chunkSize;
+uniform ivec3 chunkCount;
+uniform int seedWordsPerChunk;
+uniform ivec3 worldSize;
+
+// world block coordinates of the first region block
+uniform ivec3 regionOrigin;
+uniform ivec3 regionSize;
+
+uniform int brickSize;
+uniform int poolPagesPerAxis;
+// distances are capped here, also used for air without any visible block in range
+uniform float distanceLimit;
+// bricks overlapping the chunk
+uniform ivec3 firstBrick;
+uniform ivec3 brickCount;
+
+// region coordinates stay below maxJumpFloodRegionSize, so no seed equals invalidSeed
+uint packCoordinates(in ivec3 coordinates)
+{
+    return uint(coordinates.x) | (uint(coordinates.y) << 11u) | (uint(coordinates.z) << 21u);
+}
+
+ivec3 unpackCoordinates(in uint seed)
+{
+    return ivec3(seed & 0x7FFu, (seed >> 11u) & 0x3FFu, seed >> 21u);
+}
+
+uint getRegionIndex(in ivec3 coordinates)
+{
+    return uint(coordinates.x + coordinates.y * regionSize.x +
+                coordinates.z * regionSize.x * regionSize.y);
+}
+
+uint getSeedBits(in ivec3 texel)
+{
+    ivec3 chunkCoordinates = texel / chunkSize;
+    ivec3 blockCoordinates = texel - chunkCoordinates * chunkSize;
+    uint chunkIndex = uint(chunkCoordinates.x + chunkCoordinates.y * chunkCount.x +
+                           chunkCoordinates.z * chunkCount.x * chunkCount.y);
+    uint blockIndex = uint(blockCoordinates.x + blockCoordinates.y * chunkSize.x +
+                           blockCoordinates.z * chunkSize.x * chunkSize.y);
+    uint word = shadowSeeds[chunkIndex * uint(seedWordsPerChunk) + blockIndex / 16u];
+    return (word >> ((blockIndex % 16u) * 2u)) & 3u;
+}
+
+// unsigned order matches the float order, needed for atomicMin
+uint toOrderedBits(in float value)
+{
+    uint bits = floatBitsToUint(value);
+    return (bits & 0x80000000u) != 0u ? ~bits : bits | 0x80000000u;
+}
+
+float fromOrderedBits(in uint bits)
+{
+    return uintBitsToFloat((bits & 0x80000000u) != 0u ? bits & 0x7FFFFFFFu : ~bits);
+}
+
+ivec3 getPageOrigin(in int page)
+{
+    return ivec3(page % poolPagesPerAxis,
+                 (page / poolPagesPerAxis) % poolPagesPerAxis,
+                 page / (poolPagesPerAxis * poolPagesPerAxis)) * (brickSize + 1);
+}
+
+uint getBrickIndex(in ivec3 brick)
+{
+    return uint(brick.x + brick.y * brickCount.x + brick.z * brickCount.x * brickCount.y);
+}
+
+int getSquaredDistance(in ivec3 coordinates, in uint seed)
+{
+    ivec3 offset = unpackCoordinates(seed) - coordinates;
+    return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+}
+
+// Same encoding as chunkUpdateShadow, but jump flooding is approximate: in air a block can end
+// up with a seed that is not its closest visible block, so distances may come out a little
+// larger than the exact transform of the CPU path. Both are capped at distanceLimit.
+float getDistance(in ivec3 block)
+{
+    ivec3 coordinates = block - regionOrigin;
+    if (any(lessThan(coordinates, ivec3(0))) || any(greaterThanEqual(coordinates, regionSize))) {
+        return distanceLimit;
+    }
+
+    uint seedBits = getSeedBits(block);
+    if ((seedBits & 1u) != 0u) {
+        return 0.0;
+    }
+    if ((seedBits & 2u) != 0u) {
+        return -0.5;
+    }
+
+    uint seed = inputSeeds[getRegionIndex(coordinates)];
+    if (seed == invalidSeed) {
+        return distanceLimit;
+    }
+    return min(sqrt(float(getSquaredDistance(coordinates, seed))), distanceLimit);
+}
+
+void resolve(in ivec3 id)
+{
+    ivec3 block = firstBrick * brickSize + id;
+    float distance = getDistance(block);
+
+    ivec3 brick = id / brickSize;
+    ivec3 local = id - brick * brickSize;
+
+    // each block is also the extra texel of the previous brick on the axes where it comes first
+    for (int i = 0; i < 8; i++) {
+        ivec3 previous = ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+        if (any(greaterThan(previous, ivec3(equal(local, ivec3(0)))))) {
+            continue;
+        }
+
+        ivec3 targetBrick = brick - previous;
+        if (any(lessThan(targetBrick, ivec3(0))) ||
+            any(greaterThanEqual(targetBrick, brickCount))) {
+            continue;
+        }
+
+        uint brickIndex = getBrickIndex(targetBrick);
+        int page = brickPages[brickIndex];
+        if (page >= 0) {
+            ivec3 pageTexel = getPageOrigin(page) + local + previous * brickSize;
+            imageStore(shadowBrickPool, pageTexel, vec4(distance));
+        }
+
+        if (i == 0 && all(lessThan(block, worldSize))) {
+            atomicMin(brickDistances[brickIndex * 2u], toOrderedBits(distance));
+            if (all(equal(local, ivec3(brickSize / 2)))) {
+                brickDistances[brickIndex * 2u + 1u] = floatBitsToUint(distance);
+            }
+        }
+    }
+}
+
+void writeBrickTable(in ivec3 brick)
+{
+    uint brickIndex = getBrickIndex(brick);
+    int page = brickPages[brickIndex];
+
+    vec4 entry = vec4(getPageOrigin(page) / (brickSize + 1), 0.0);
+    if (page < 0) {
+        float minDistance = fromOrderedBits(brickDistances[brickIndex * 2u]);
+        uint centerBits = brickDistances[brickIndex * 2u + 1u];
+        float centerDistance =
+            centerBits == unsetDistance ? minDistance : uintBitsToFloat(centerBits);
+        entry = vec4(-1.0, centerDistance, 0.0, minDistance);
+    }
+
+    imageStore(shadowBrickTable, firstBrick + brick, entry);
+}
+
+void main()
+{
+    ivec3 coordinates = ivec3(gl_GlobalInvocationID);
+
+    if (stage == stageResolve) {
+        if (all(lessThanEqual(coordinates, brickCount * brickSize))) {
+            resolve(coordinates);
+        }
+        return;
+    }
+
+    if (stage == stageBrickTable) {
+        if (all(lessThan(coordinates, brickCount))) {
+            writeBrickTable(coordinates);
+        }
+        return;
+    }
+
+    if (any(greaterThanEqual(coordinates, regionSize))) {
+        return;
+    }
+
+    uint regionIndex = getRegionIndex(coordinates);
+
+    if (stage == stageInit) {
+        bool bIsVisible = (getSeedBits(regionOrigin + coordinates) & 1u) != 0u;
+        outputSeeds[regionIndex] = bIsVisible ? packCoordinates(coordinates) : invalidSeed;
+        return;
+    }
+
+    uint bestSeed = inputSeeds[regionIndex];
+    int bestDistance =
+        bestSeed == invalidSeed ? 0x7FFFFFFF : getSquaredDistance(coordinates, bestSeed);
+
+    for (int z = -1; z <= 1; z++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                ivec3 neighbour = coordinates + ivec3(x, y, z) * stepSize;
+                if (any(lessThan(neighbour, ivec3(0))) ||
+                    any(greaterThanEqual(neighbour, regionSize))) {
+                    continue;
+                }
+
+                uint seed = inputSeeds[getRegionIndex(neighbour)];
+                if (seed == invalidSeed) {
+                    continue;
+                }
+
+                int distance = getSquaredDistance(coordinates, seed);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestSeed = seed;
+                }
+            }
+        }
+    }
+
+    outputSeeds[regionIndex] = bestSeed;
+}
@@ -19,6 +19,7 @@
 #include "core/vs_game.h"
 #include "core/vs_debug_draw.h"
 #include "core/vs_input_handler.h"
+#include "core/vs_thread_pool.h"
 
 #include "world/vs_chunk_manager.h"
 
@@ -82,6 +83,14 @@ int VSApp::initialize()
 
     // auto monkeyModel = std::make_shared<VSModel>("monkey.obj");
 
+    // worlds submit chunk updates to the pool, so it has to exist before the game creates them
+    threadPool = new VSThreadPool(VSThreadPool::getDefaultWorkerCount());
+    VSLog::Log(
+        VSLog::Category::Core,
+        VSLog::Level::info,
+        "Successfully started thread pool with {} workers",
+        threadPool->getWorkerCount());
+
     VSLog::Log(VSLog::Category::Core, VSLog::Level::info, "Successfully initialized logger");
 
     // TODO this has t be refactored at some point
@@ -229,6 +238,11 @@ std::chrono::high_resolution_clock::time_point VSApp::getStartTime() const
     return appStart;
 }
 
+VSThreadPool* VSApp::getThreadPool() const
+{
+    return threadPool;
+}
+
 VSApp* VSApp::getInstance()
 {
     return instance;
@@ -267,7 +281,24 @@ int VSApp::mainLoop()
         UI->getMutableState()->totalBlockCount = world->getChunkManager()->getTotalBlockCount();
         UI->getMutableState()->visibleBlockCount = world->getChunkManager()->getVisibleBlockCount();
         UI->getMutableState()->drawnBlockCount = world->getChunkManager()->getDrawnBlockCount();
+        UI->getMutableState()->drawnTriangleCount =
+            world->getChunkManager()->getDrawnTriangleCount();
+        UI->getMutableState()->drawnVertexCount = world->getChunkManager()->getDrawnVertexCount();
         UI->getMutableState()->drawCallCount = world->getChunkManager()->getDrawCallCount();
+        UI->getMutableState()->drawCommandCount = world->getChunkManager()->getDrawCommandCount();
+        UI->getMutableState()->uploadedInstanceBytes =
+            world->getChunkManager()->getUploadedInstanceBytes();
+        UI->getMutableState()->chunkMemoryMiB =
+            static_cast<int>(world->getChunkManager()->getChunkMemoryBytes() >> 20);
+        UI->getMutableState()->shadowPageCount = world->getChunkManager()->getShadowPageCount();
+        UI->getMutableState()->visibilityRebuildQueueSize =
+            world->getChunkManager()->getVisibilityRebuildQueueSize();
+        UI->getMutableState()->visibilityRebuildWaitMs =
+            world->getChunkManager()->getVisibilityRebuildWaitSeconds() * 1000.F;
+        UI->getMutableState()->shadowRebuildQueueSize =
+            world->getChunkManager()->getShadowRebuildQueueSize();
+        UI->getMutableState()->shadowRebuildWaitMs =
+            world->getChunkManager()->getShadowRebuildWaitSeconds() * 1000.F;
 
         world->setDirectLightDir(UI->getState()->directLightDir);
 
@@ -309,6 +340,10 @@ int VSApp::mainLoop()
 
     gameThread.join();
 
+    // finishes pending saves
+    delete threadPool;
+    threadPool = nullptr;
+
     // Cleanup
     UI->cleanup();
 
@@ -315,16 +315,15 @@ void VSRTSCameraController::setCameraRelativeXZ(float relativeX, float relativeZ
     float absoluteZ = (relativeZ - 0.5) * worldSize.z;
     int blockX = std::round(absoluteX);
     int blockZ = std::round(absoluteZ);
-    for (int y = -worldSize.y / 2; y < worldSize.y / 2; y++)
+    const auto surface = world->getChunkManager()->getSurface({blockX, 0, blockZ});
+    if (surface.bHasHit)
     {
-        glm::ivec3 blockCoordinates = {blockX, y, blockZ};
-        if (world->getChunkManager()->getBlock(blockCoordinates) > 0)
-        {
-            const auto newPosition =
-                glm::vec3({absoluteX, y, absoluteZ}) - cam->getFront() * radius;
-            targetPosition = newPosition;
-            adaptToFixpoint();
-            cam->setPosition(targetPosition);
-        }
+        // y of the highest block, not of its top face
+        const auto newPosition =
+            glm::vec3({absoluteX, surface.hitLocation.y - 1.F, absoluteZ}) -
+            cam->getFront() * radius;
+        targetPosition = newPosition;
+        adaptToFixpoint();
+        cam->setPosition(targetPosition);
     }
 }
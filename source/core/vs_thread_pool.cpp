@@ -0,0 +1,137 @@
+#include "core/vs_thread_pool.h"
+
+#include <algorithm>
+
+thread_local const VSThreadPool* VSThreadPool::currentPool = nullptr;
+thread_local std::size_t VSThreadPool::currentWorkerIndex = 0;
+
+VSThreadPool::VSThreadPool(std::size_t workerCount)
+{
+    workerCount = std::max<std::size_t>(workerCount, 1);
+
+    queues.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; i++)
+    {
+        queues.push_back(std::make_unique<VSWorkerQueue>());
+    }
+
+    workers.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&VSThreadPool::workerLoop, this, i);
+    }
+}
+
+VSThreadPool::~VSThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        bShouldStop = true;
+    }
+    wakeUp.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+std::size_t VSThreadPool::getWorkerCount() const
+{
+    return workers.size();
+}
+
+std::size_t VSThreadPool::getQueuedTaskCount() const
+{
+    return queuedTaskCount;
+}
+
+std::size_t VSThreadPool::getDefaultWorkerCount()
+{
+    const auto hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads == 0)
+    {
+        return 4;
+    }
+    return std::max(hardwareThreads, 3U) - 2;
+}
+
+void VSThreadPool::push(VSTask task)
+{
+    // tasks spawned by a worker stay on its own deque, everything else is spread round robin
+    const auto queueIndex =
+        currentPool == this ? currentWorkerIndex : nextQueueIndex++ % queues.size();
+
+    // Counted before it can be popped, so the count never drops below the queued tasks. Workers
+    // woken in between only retry until the task shows up in the deque.
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedTaskCount++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+bool VSThreadPool::popOwn(std::size_t workerIndex, VSTask& task)
+{
+    // most work is submitted from outside the pool, so the owner keeps submission order
+    auto& queue = *queues[workerIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool VSThreadPool::steal(std::size_t workerIndex, VSTask& task)
+{
+    // thieves take from the other end to keep contention with the owner low
+    for (std::size_t offset = 1; offset < queues.size(); offset++)
+    {
+        auto& queue = *queues[(workerIndex + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    return false;
+}
+
+void VSThreadPool::workerLoop(std::size_t workerIndex)
+{
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    while (true)
+    {
+        VSTask task;
+        if (popOwn(workerIndex, task) || steal(workerIndex, task))
+        {
+            // only decreased after a successful pop, see push
+            queuedTaskCount--;
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return bShouldStop || queuedTaskCount > 0; });
+        if (bShouldStop && queuedTaskCount == 0)
+        {
+            return;
+        }
+    }
+}
@@ -2,6 +2,8 @@
 #include <glm/fwd.hpp>
 #include "game/components/bounds.h"
 #include "ui/vs_parser.h"
+#include "core/vs_app.h"
+#include "core/vs_thread_pool.h"
 
 void updateEditorSystem(entt::registry& mainRegistry)
 {
@@ -34,24 +36,14 @@ void updateEditorSystem(entt::registry& mainRegistry)
 
             if (inputs.rightButtonState == InputState::JustUp)
             {
-                const auto low = discreteMouse + bounds.min;
-                const auto high = discreteMouse + bounds.max;
-
-                for (int x = low.x; x < high.x; x++)
-                {
-                    for (int y = low.y; y < high.y; y++)
-                    {
-                        for (int z = low.z; z < high.z; z++)
-                        {
-                            worldContext.world->getChunkManager()->setBlock(
-                                {x, y, z}, uiContext.editorSelectedBlockID + 1);
-                        }
-                    }
-                }
+                worldContext.world->getChunkManager()->enqueueFillBox(
+                    discreteMouse + bounds.min,
+                    discreteMouse + bounds.max,
+                    uiContext.editorSelectedBlockID + 1);
             }
             else if (inputs.middleButtonState == InputState::JustUp)
             {
-                worldContext.world->getChunkManager()->setBlock(
+                worldContext.world->getChunkManager()->enqueueSetBlock(
                     mouseLocation - 0.05F * inputs.mouseTrace.hitNormal, 0);
             }
         }
@@ -59,25 +51,31 @@ void updateEditorSystem(entt::registry& mainRegistry)
 
     if (uiContext.bShouldSaveToFile)
     {
-        const VSChunkManager::VSWorldData worldData =
-            worldContext.world->getChunkManager()->getData();
+        // take the data on the game thread, only writing the file happens in the background
+        VSChunkManager::VSWorldData worldData = worldContext.world->getChunkManager()->getData();
         VSLog::Log(VSLog::Category::Core, VSLog::Level::info, "{}", worldData.blocks.size());
-        VSParser::writeToFile(worldData, uiContext.saveFilePath);
+        VSApp::getInstance()->getThreadPool()->submit(
+            [worldData = std::move(worldData), saveFilePath = uiContext.saveFilePath]() {
+                VSParser::writeToFile(worldData, saveFilePath);
+            });
         uiContext.bShouldSaveToFile = false;
     }
 
     if (uiContext.bShouldLoadFromFile)
     {
         VSChunkManager::VSWorldData worldData = VSParser::readFromFile(uiContext.loadFilePath);
-        worldContext.world->getChunkManager()->initFromData(worldData);
+        worldContext.world->getChunkManager()->initFromData(std::move(worldData));
         uiContext.bShouldLoadFromFile = false;
     }
 
     if (uiContext.bShouldSaveBuilding)
     {
         // Extract editor plane and save building
-        const VSChunkManager::VSBuildingData buildData = extractBuildFromPlane(worldContext.world);
-        VSParser::writeBuildToFile(buildData, uiContext.saveBuildingPath);
+        VSChunkManager::VSBuildingData buildData = extractBuildFromPlane(worldContext.world);
+        VSApp::getInstance()->getThreadPool()->submit(
+            [buildData = std::move(buildData), saveBuildingPath = uiContext.saveBuildingPath]() {
+                VSParser::writeBuildToFile(buildData, saveBuildingPath);
+            });
         uiContext.bShouldSaveBuilding = false;
     }
 }
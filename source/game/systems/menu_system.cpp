@@ -9,6 +9,7 @@
 #include "game/systems/delete_system.h"
 #include "ui/vs_parser.h"
 #include "core/vs_app.h"
+#include "core/vs_thread_pool.h"
 
 void updateMenuSystem(entt::registry& mainRegistry, entt::registry& buildingRegistry)
 {
@@ -62,15 +63,14 @@ void updateMenuSystem(entt::registry& mainRegistry, entt::registry& buildingRegi
     if (app->getWorldName() == uiContext.menuWorldName)
     {
         if (uiContext.bIsMenuWorldInitialized &&
-            !world->getChunkManager()->shouldReinitializeChunks())
+            !world->getChunkManager()->shouldReinitializeChunks() &&
+            !uiContext.terrainGeneration.valid())
         {
             // Rotate camera while in menu
             world->getCamera()->setPitchYaw(
                 0.F, world->getCamera()->getYaw() + worldContext.deltaSeconds * 3.F);
 
-            const auto groundTraceStart = glm::vec3(0.F, 200.F, 0.F);
-            const auto groundTraceResult = world->getChunkManager()->lineTrace(
-                groundTraceStart, groundTraceStart - glm::vec3(0.F, 500.F, 0.F));
+            const auto groundTraceResult = world->getChunkManager()->getSurface({0.F, 0.F, 0.F});
 
             const auto collisionFrontStart =
                 groundTraceResult.hitLocation + groundTraceResult.hitNormal + 8.F;
@@ -145,66 +145,86 @@ void updateMenuSystem(entt::registry& mainRegistry, entt::registry& buildingRegi
     // Update world state with ui state
     if (uiContext.bShouldUpdateChunks)
     {
-        glm::ivec2 chunkCount = {4, 4};
+        glm::ivec3 chunkCount = {4, 2, 4};
 
         if (uiContext.worldSize == 0)
         {
             // Small
-            chunkCount = {16, 16};
+            chunkCount = {16, 2, 16};
         }
         else if (uiContext.worldSize == 1)
         {
             // Medium
-            chunkCount = {32, 32};
+            chunkCount = {32, 2, 32};
         }
         else if (uiContext.worldSize == 2)
         {
             // Large
-            chunkCount = {64, 64};
+            chunkCount = {64, 2, 64};
         }
         else if (uiContext.worldSize == 3)
         {
             // Tiny for debug
-            chunkCount = {2, 2};
+            chunkCount = {2, 2, 2};
         }
 
         if (uiContext.bEditorActive)
         {
-            chunkCount = {4, 4};
+            chunkCount = {4, 2, 4};
         }
 
-        constexpr glm::ivec3 chunkSize = {32, 128, 32};
+        // two layers of chunks make up the world height, so chunks above and below the
+        // surface can be culled and rebuilt on their own
+        constexpr glm::ivec3 chunkSize = {32, 64, 32};
 
         world->getChunkManager()->setChunkDimensions(chunkSize, chunkCount);
         uiContext.bShouldUpdateChunks = false;
     }
 
-    if (uiContext.bShouldGenerateTerrain && !world->getChunkManager()->shouldReinitializeChunks())
+    if (uiContext.bShouldGenerateTerrain && !world->getChunkManager()->shouldReinitializeChunks() &&
+        !uiContext.terrainGeneration.valid())
     {
         uiContext.bShouldGenerateTerrain = false;
 
         uiContext.bShowLoading = true;
-        if (!uiContext.bShouldLoadFromFile)
-        {
-            if (uiContext.selectedBiomeType == 0)
-            {
-                VSTerrainGeneration::buildStandard(world);
-            }
-            else if (uiContext.selectedBiomeType == 1)
-            {
-                VSTerrainGeneration::buildMountains(world);
-            }
-            else if (uiContext.selectedBiomeType == 2)
-            {
-                VSTerrainGeneration::buildDesert(world);
-            }
-        }
-        if (uiContext.bShouldLoadFromFile)
-        {
-            VSChunkManager::VSWorldData worldData = VSParser::readFromFile(uiContext.loadFilePath);
-            world->getChunkManager()->initFromData(worldData);
-            uiContext.bShouldLoadFromFile = false;
-        }
+
+        const auto selectedBiomeType = uiContext.selectedBiomeType;
+        const auto bShouldLoadFromFile = uiContext.bShouldLoadFromFile;
+        const auto loadFilePath = uiContext.loadFilePath;
+        uiContext.bShouldLoadFromFile = false;
+
+        uiContext.terrainGeneration = app->getThreadPool()->submit(
+            [world, selectedBiomeType, bShouldLoadFromFile, loadFilePath]() {
+                if (!bShouldLoadFromFile)
+                {
+                    if (selectedBiomeType == 0)
+                    {
+                        VSTerrainGeneration::buildStandard(world);
+                    }
+                    else if (selectedBiomeType == 1)
+                    {
+                        VSTerrainGeneration::buildMountains(world);
+                    }
+                    else if (selectedBiomeType == 2)
+                    {
+                        VSTerrainGeneration::buildDesert(world);
+                    }
+                }
+                if (bShouldLoadFromFile)
+                {
+                    VSChunkManager::VSWorldData worldData = VSParser::readFromFile(loadFilePath);
+                    world->getChunkManager()->initFromData(std::move(worldData));
+                }
+            });
+    }
+
+    // generated blocks only show up once the main thread has taken them over
+    if (uiContext.terrainGeneration.valid() &&
+        uiContext.terrainGeneration.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready &&
+        !world->getChunkManager()->isWorldDataPending())
+    {
+        uiContext.terrainGeneration.get();
         uiContext.bShowLoading = false;
 
         if (!uiContext.bEditorActive)
@@ -94,7 +94,7 @@ void updatePlacementSystem(entt::registry& mainRegistry, entt::registry& buildin
 
             if (!uiContext.bIsBuildingPreviewInitialized)
             {
-                previewChunkManager->setChunkDimensions(templateBlocks.size * 3, {2, 2});
+                previewChunkManager->setChunkDimensions(templateBlocks.size * 3, {2, 1, 2});
                 uiContext.bIsBuildingPreviewInitialized = true;
             }
 
@@ -102,31 +102,13 @@ void updatePlacementSystem(entt::registry& mainRegistry, entt::registry& buildin
                 !previewChunkManager->shouldReinitializeChunks() &&
                 !uiContext.bIsBuildingPreviewConstructed)
             {
-                for (int x = 0; x < templateBlocks.size.x; x++)
-                {
-                    for (int y = 0; y < templateBlocks.size.y; y++)
-                    {
-                        for (int z = 0; z < templateBlocks.size.z; z++)
-                        {
-                            const auto offset = glm::vec3(
-                                selectedBuildingTemplateBounds.min.x,
-                                0,
-                                selectedBuildingTemplateBounds.min.z);
-                            auto blockCoords = glm::vec3{x, y, z};
-                            if (uiContext.bShouldRotateBuilding)
-                            {
-                                const auto tempX = blockCoords.x;
-                                blockCoords.x = blockCoords.z;
-                                blockCoords.z = tempX;
-                            }
-                            previewChunkManager->setBlock(
-                                blockCoords + offset,
-                                templateBlocks.blocks
-                                    [x + y * templateBlocks.size.x +
-                                     z * templateBlocks.size.x * templateBlocks.size.y]);
-                        }
-                    }
-                }
+                const auto offset = glm::vec3(
+                    selectedBuildingTemplateBounds.min.x, 0, selectedBuildingTemplateBounds.min.z);
+                previewChunkManager->enqueueStamp(
+                    offset,
+                    templateBlocks.size,
+                    templateBlocks.blocks,
+                    uiContext.bShouldRotateBuilding);
                 uiContext.bIsBuildingPreviewConstructed = true;
             }
 
@@ -268,25 +250,9 @@ void placeBuildingBlocks(
     const Blocks& templateBlocks,
     bool bIsRotated)
 {
-    for (int x = 0; x < templateBlocks.size.x; x++)
-    {
-        for (int y = 0; y < templateBlocks.size.y; y++)
-        {
-            for (int z = 0; z < templateBlocks.size.z; z++)
-            {
-                auto blockCoords = glm::vec3{x, y, z};
-                if (bIsRotated)
-                {
-                    const auto tempX = blockCoords.x;
-                    blockCoords.x = blockCoords.z;
-                    blockCoords.z = tempX;
-                }
-                worldContext.world->getChunkManager()->setBlock(
-                    newBuildingLocation + blockCoords + selectedBuildingTemplateBounds.min,
-                    templateBlocks.blocks
-                        [x + y * templateBlocks.size.x +
-                         z * templateBlocks.size.x * templateBlocks.size.y]);
-            }
-        }
-    }
+    worldContext.world->getChunkManager()->enqueueStamp(
+        newBuildingLocation + selectedBuildingTemplateBounds.min,
+        templateBlocks.size,
+        templateBlocks.blocks,
+        bIsRotated);
 }
\ No newline at end of file
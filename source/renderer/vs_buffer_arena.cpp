@@ -0,0 +1,168 @@
+#include "renderer/vs_buffer_arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+VSBufferArena::VSBufferArena(GLenum target, std::size_t elementSize, std::size_t initialCapacity)
+    : target(target)
+    , elementSize(elementSize)
+{
+    grow(std::max<std::size_t>(initialCapacity, 1));
+}
+
+VSBufferArena::~VSBufferArena()
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+VSBufferArena::VSAllocation VSBufferArena::allocate(std::size_t elementCount)
+{
+    if (elementCount == 0)
+    {
+        return {};
+    }
+
+    // first fit
+    auto freeRange = std::find_if(
+        freeRanges.begin(), freeRanges.end(), [elementCount](const auto& offsetAndSize) {
+            return offsetAndSize.second >= elementCount;
+        });
+
+    if (freeRange == freeRanges.end())
+    {
+        grow(capacity + elementCount);
+        // after growing the last free range is large enough
+        freeRange = std::prev(freeRanges.end());
+    }
+
+    const auto [offset, size] = *freeRange;
+    freeRanges.erase(freeRange);
+    if (size > elementCount)
+    {
+        freeRanges.emplace(offset + elementCount, size - elementCount);
+    }
+
+    usedElementCount += elementCount;
+
+    return {offset, elementCount};
+}
+
+void VSBufferArena::free(VSAllocation& allocation)
+{
+    if (allocation.size == 0)
+    {
+        return;
+    }
+
+    usedElementCount -= allocation.size;
+    addFreeRange(allocation.offset, allocation.size);
+
+    allocation = {};
+}
+
+void VSBufferArena::reset()
+{
+    freeRanges.clear();
+    freeRanges.emplace(0, capacity);
+    usedElementCount = 0;
+}
+
+void VSBufferArena::upload(
+    const VSAllocation& allocation,
+    std::size_t elementOffset,
+    const void* data,
+    std::size_t elementCount)
+{
+    assert(elementOffset + elementCount <= allocation.size);
+
+    if (elementCount == 0)
+    {
+        return;
+    }
+
+    glBindBuffer(target, buffer);
+    glBufferSubData(
+        target,
+        (allocation.offset + elementOffset) * elementSize,
+        elementCount * elementSize,
+        data);
+
+    uploadedBytes += elementCount * elementSize;
+}
+
+GLuint VSBufferArena::getBuffer() const
+{
+    return buffer;
+}
+
+std::size_t VSBufferArena::getElementSize() const
+{
+    return elementSize;
+}
+
+std::size_t VSBufferArena::getCapacity() const
+{
+    return capacity;
+}
+
+std::size_t VSBufferArena::getUsedElementCount() const
+{
+    return usedElementCount;
+}
+
+std::size_t VSBufferArena::consumeUploadedBytes()
+{
+    const auto result = uploadedBytes;
+    uploadedBytes = 0;
+    return result;
+}
+
+void VSBufferArena::grow(std::size_t minimumCapacity)
+{
+    const auto newCapacity = std::max(minimumCapacity, capacity * 2);
+
+    GLuint newBuffer = 0;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * elementSize, nullptr, GL_DYNAMIC_DRAW);
+
+    if (capacity != 0)
+    {
+        // keep existing allocations valid, the copy stays on the GPU
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * elementSize);
+        glDeleteBuffers(1, &buffer);
+    }
+
+    buffer = newBuffer;
+
+    addFreeRange(capacity, newCapacity - capacity);
+    capacity = newCapacity;
+}
+
+void VSBufferArena::addFreeRange(std::size_t offset, std::size_t size)
+{
+    auto [inserted, bWasInserted] = freeRanges.emplace(offset, size);
+    assert(bWasInserted);
+    (void)bWasInserted;
+
+    // merge with next range
+    const auto next = std::next(inserted);
+    if (next != freeRanges.end() && inserted->first + inserted->second == next->first)
+    {
+        inserted->second += next->second;
+        freeRanges.erase(next);
+    }
+
+    // merge with previous range
+    if (inserted != freeRanges.begin())
+    {
+        const auto prev = std::prev(inserted);
+        if (prev->first + prev->second == inserted->first)
+        {
+            prev->second += inserted->second;
+            freeRanges.erase(inserted);
+        }
+    }
+}
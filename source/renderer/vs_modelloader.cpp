@@ -8,6 +8,22 @@
 #include "renderer/vs_textureloader.h"
 
 VSVertexContext* loadVertexContext(std::string const& path)
+{
+    std::vector<VSVertexData> vertexDataList;
+    std::vector<GLuint> triangleIndices;
+
+    if (!loadVertexData(path, vertexDataList, triangleIndices))
+    {
+        return {};
+    }
+
+    return new VSVertexContext(vertexDataList, triangleIndices);
+}
+
+bool loadVertexData(
+    std::string const& path,
+    std::vector<VSVertexData>& vertexData,
+    std::vector<GLuint>& triangleIndices)
 {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(
@@ -19,19 +35,31 @@ VSVertexContext* loadVertexContext(std::string const& path)
             VSLog::Level::err,
             "{0}",
             std::string("ERROR::ASSIMP:: ") + importer.GetErrorString());
-        return {};
+        return false;
     }
 
-    return processMeshVertices(scene->mMeshes[0]);
+    processMeshVertices(scene->mMeshes[0], vertexData, triangleIndices);
+    return true;
 }
 
 VSVertexContext* processMeshVertices(aiMesh*& mesh)
+{
+    std::vector<VSVertexData> vertexDataList;
+    std::vector<GLuint> triangleIndices;
+
+    processMeshVertices(mesh, vertexDataList, triangleIndices);
+
+    return new VSVertexContext(vertexDataList, triangleIndices);
+}
+
+void processMeshVertices(
+    aiMesh*& mesh,
+    std::vector<VSVertexData>& vertexDataList,
+    std::vector<GLuint>& triangleIndices)
 {
     // the following only works if assimp and glm vector have the same size
     assert(sizeof(glm::vec3) == sizeof(aiVector3D));
 
-    std::vector<VSVertexData> vertexDataList;
-
     for (std::size_t i = 0; i < mesh->mNumVertices; i++)
     {
         VSVertexData currentVertex{};
@@ -42,8 +70,6 @@ VSVertexContext* processMeshVertices(aiMesh*& mesh)
         vertexDataList.emplace_back(currentVertex);
     }
 
-    std::vector<GLuint> triangleIndices;
-
     // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the
     // corresponding vertex indices.
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
@@ -55,6 +81,4 @@ VSVertexContext* processMeshVertices(aiMesh*& mesh)
             triangleIndices.push_back(face.mIndices[j]);
         }
     }
-
-    return new VSVertexContext(vertexDataList, triangleIndices);
 }
\ No newline at end of file
@@ -1,13 +1,14 @@
 #include "renderer/vs_shader.h"
 
-VSShader::VSShader(const char* name, bool bIsComputeShader)
+VSShader::VSShader(const char* name, bool bIsComputeShader, const std::vector<std::string>& defines)
 {
     const auto vertexShaderPath = (shaderDirectory / name).replace_extension(".vs");
 
     ID = glCreateProgram();
 
     if (bIsComputeShader) {
-        GLuint computeShaderID = compileShader(vertexShaderPath, GL_COMPUTE_SHADER);
+        const auto computeShaderPath = (shaderDirectory / name).replace_extension(".cs");
+        GLuint computeShaderID = compileShader(computeShaderPath, GL_COMPUTE_SHADER, defines);
         glAttachShader(ID, computeShaderID);
 
         glLinkProgram(ID);
@@ -17,7 +18,7 @@ VSShader::VSShader(const char* name, bool bIsComputeShader)
         glDetachShader(ID, computeShaderID);
         glDeleteShader(computeShaderID);
     } else {
-        GLuint vertexShaderID = compileShader(vertexShaderPath, GL_VERTEX_SHADER);
+        GLuint vertexShaderID = compileShader(vertexShaderPath, GL_VERTEX_SHADER, defines);
         glAttachShader(ID, vertexShaderID);
 
         const auto fragmentShaderPath = (shaderDirectory / name).replace_extension(".fs");
@@ -34,7 +35,7 @@ VSShader::VSShader(const char* name, bool bIsComputeShader)
         }
         else
         {
-            fragmentShaderID = compileShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
+            fragmentShaderID = compileShader(fragmentShaderPath, GL_FRAGMENT_SHADER, defines);
             glAttachShader(ID, fragmentShaderID);
         }
         glLinkProgram(ID);
@@ -110,12 +111,27 @@ bool VSShader::checkProgramLinkErrors(unsigned int programID)
     return success == 0;
 }
 
-GLuint VSShader::compileShader(const std::filesystem::path& shaderPath, GLenum shaderType)
+GLuint VSShader::compileShader(
+    const std::filesystem::path& shaderPath,
+    GLenum shaderType,
+    const std::vector<std::string>& defines)
 {
     std::ifstream shaderStream(shaderPath);
     std::string shaderString(
         (std::istreambuf_iterator<char>(shaderStream)), std::istreambuf_iterator<char>());
 
+    if (!defines.empty())
+    {
+        // #version has to stay the first line
+        std::string defineString;
+        for (const auto& define : defines)
+        {
+            defineString += "#define " + define + "\n";
+        }
+        const auto versionEnd = shaderString.find('\n', shaderString.find("#version"));
+        shaderString.insert(versionEnd == std::string::npos ? 0 : versionEnd + 1, defineString);
+    }
+
     VSLog::Log(
         VSLog::Category::Shader, VSLog::Level::info, "Compiling shader: {}", shaderPath.string());
 
@@ -16,7 +16,8 @@ namespace VSParser
         // TODO: Check if file is empty etc.
 
         nlohmann::json json;
-        json["chunkCount"] = {worldData.chunkCount.x, worldData.chunkCount.y};
+        json["chunkCount"] = {
+            worldData.chunkCount.x, worldData.chunkCount.y, worldData.chunkCount.z};
         json["chunkSize"] = {worldData.chunkSize.x, worldData.chunkSize.y, worldData.chunkSize.z};
         json["blocks"] = worldData.blocks;
         outFile << json << std::endl;
@@ -100,10 +101,16 @@ namespace VSParser
         json.at("blocks").get_to(worldData.blocks);
         std::vector<int> chunkSizeVec(3);
         json.at("chunkSize").get_to(chunkSizeVec);
-        std::vector<int> chunkCountVec(2);
+        std::vector<int> chunkCountVec(3);
         json.at("chunkCount").get_to(chunkCountVec);
+        if (chunkCountVec.size() == 2)
+        {
+            // worlds saved before chunks were stacked along y have a single layer of chunks
+            chunkCountVec = {chunkCountVec.at(0), 1, chunkCountVec.at(1)};
+        }
         worldData.chunkCount.x = chunkCountVec.at(0);
         worldData.chunkCount.y = chunkCountVec.at(1);
+        worldData.chunkCount.z = chunkCountVec.at(2);
         worldData.chunkSize.x = chunkSizeVec.at(0);
         worldData.chunkSize.y = chunkSizeVec.at(1);
         worldData.chunkSize.z = chunkSizeVec.at(2);
@@ -155,17 +155,43 @@ void VSUI::renderDebugGUI()
     ImGui::Checkbox("draw chunk border", (bool*)&uiState->bShouldDrawChunkBorder);
     ImGui::Checkbox("freeze frustum", (bool*)&uiState->bShouldFreezeFrustum);
     ImGui::Checkbox("shadows", (bool*)&uiState->bAreShadowsEnabled);
+    const char* shadowBuildModes[] = {"CPU distance transform", "GPU jump flooding"};
+    ImGui::Combo(
+        "Shadow build mode",
+        (int*)&uiState->shadowBuildMode,
+        shadowBuildModes,
+        IM_ARRAYSIZE(shadowBuildModes));
     ImGui::Checkbox("AO", (bool*)&uiState->bIsAmbientOcclusionEnabled);
     ImGui::Checkbox("Show AO", (bool*)&uiState->bShouldShowAO);
     ImGui::Checkbox("Show UVs", (bool*)&uiState->bShouldShowUV);
     ImGui::Checkbox("Show Normals", (bool*)&uiState->bShouldShowNormals);
     ImGui::Checkbox("Show Light", (bool*)&uiState->bShouldShowLight);
+    const char* chunkDrawModes[] = {"Instanced (GL 4.0)", "Multi draw indirect", "GPU culled"};
+    ImGui::Combo(
+        "Chunk draw mode",
+        (int*)&uiState->chunkDrawMode,
+        chunkDrawModes,
+        IM_ARRAYSIZE(chunkDrawModes));
     ImGui::Text(
         "Blocks Total; Visible; Drawn: %d; %d; %d",
         uiState->totalBlockCount,
         uiState->visibleBlockCount,
         uiState->drawnBlockCount);
-    ImGui::Text("Drawcalls %d/64", uiState->drawCallCount);
+    ImGui::Text(
+        "Triangles; Vertices: %d; %d", uiState->drawnTriangleCount, uiState->drawnVertexCount);
+    ImGui::Text(
+        "Drawcalls; Commands: %d; %d", uiState->drawCallCount, uiState->drawCommandCount);
+    ImGui::Text("Chunk upload %d B/frame", uiState->uploadedInstanceBytes);
+    ImGui::Text("Chunk memory %d MiB", uiState->chunkMemoryMiB);
+    ImGui::Text("Shadow pages %d", uiState->shadowPageCount);
+    ImGui::Text(
+        "Visibility rebuilds queued %d (%.1f ms wait)",
+        uiState->visibilityRebuildQueueSize,
+        uiState->visibilityRebuildWaitMs);
+    ImGui::Text(
+        "Shadow rebuilds queued %d (%.1f ms wait)",
+        uiState->shadowRebuildQueueSize,
+        uiState->shadowRebuildWaitMs);
     ImGui::Text(
         "Application average %.3f ms/frame (%.1f FPS)",
         1000.0f / ImGui::GetIO().Framerate,
@@ -2,6 +2,7 @@
 #include <glm/fwd.hpp>
 #include <glm/gtx/easing.hpp>
 #include <random>
+#include <utility>
 #include <vector>
 #include "ui/vs_parser.h"
 #include "world/generator/vs_heightmap.h"
@@ -16,6 +17,7 @@ namespace VSTerrainGeneration
         auto chunkManager = world->getChunkManager();
         glm::ivec3 worldSize = chunkManager->getWorldSize();
         glm::ivec3 worldSizeHalf = worldSize / 2;
+        auto worldData = chunkManager->createWorldData();
         VSHeightmap flatHM = VSHeightmap(worldSize.y / 4, 3, 0.005F, worldSize.y / 4, 2.F, 0.5F);
         VSHeightmap mountainHM =
             VSHeightmap(worldSize.y / 2, 2, 0.02F, worldSize.y / 2, 2.F, 0.125F);
@@ -82,7 +84,7 @@ namespace VSTerrainGeneration
 
                 for (int y = -worldSizeHalf.y; y < height - worldSizeHalf.y; y++)
                 {
-                    chunkManager->setBlock({x, y, z}, blockID);
+                    worldData.setBlock({x, y, z}, blockID);
                 }
 
                 int tree = dis(gen);
@@ -93,7 +95,7 @@ namespace VSTerrainGeneration
                         if (x > -worldSizeHalf.x + 1 && z > -worldSizeHalf.z + 1 &&
                             x < worldSizeHalf.x - 3 && z < worldSizeHalf.z - 3)
                         {
-                            treeAt(world, x, height - worldSizeHalf.y, z);
+                            treeAt(worldData, x, height - worldSizeHalf.y, z);
                         }
                     }
                 }
@@ -101,18 +103,21 @@ namespace VSTerrainGeneration
                 {
                     if (height < grassLine && height > sandLine)
                     {
-                        placeModelAt(world, smallBirch, x, height - worldSizeHalf.y, z);
+                        placeModelAt(worldData, smallBirch, x, height - worldSizeHalf.y, z);
                     }
                 }
                 else if (tree == 2)
                 {
                     if (height < grassLine && height > sandLine)
                     {
-                        placeModelAt(world, largeBirch, x, height - worldSizeHalf.y, z);
+                        placeModelAt(worldData, largeBirch, x, height - worldSizeHalf.y, z);
                     }
                 }
             }
         }
+
+        // the main thread swaps the blocks in between frames
+        chunkManager->setWorldData(std::move(worldData));
     }
 
     void buildMountains(VSWorld* world)
@@ -120,6 +125,7 @@ namespace VSTerrainGeneration
         auto chunkManager = world->getChunkManager();
         glm::ivec3 worldSize = chunkManager->getWorldSize();
         glm::ivec3 worldSizeHalf = worldSize / 2;
+        auto worldData = chunkManager->createWorldData();
         VSHeightmap hm = VSHeightmap(worldSize.y, 4, 0.01F, worldSize.y, 1.F, 0.5F);
 
         std::random_device rd;   // Will be used to obtain a seed for the random number engine
@@ -157,7 +163,7 @@ namespace VSTerrainGeneration
 
                 for (int y = -worldSizeHalf.y; y < height - worldSizeHalf.y; y++)
                 {
-                    chunkManager->setBlock({x, y, z}, blockID);
+                    worldData.setBlock({x, y, z}, blockID);
                 }
                 if (tree == 0)
                 {
@@ -166,12 +172,15 @@ namespace VSTerrainGeneration
                         if (x > -worldSizeHalf.x + 1 && z > -worldSizeHalf.z + 1 &&
                             x < worldSizeHalf.x - 3 && z < worldSizeHalf.z - 3)
                         {
-                            treeAt(world, x, height - worldSizeHalf.y, z);
+                            treeAt(worldData, x, height - worldSizeHalf.y, z);
                         }
                     }
                 }
             }
         }
+
+        // the main thread swaps the blocks in between frames
+        chunkManager->setWorldData(std::move(worldData));
     }
 
     void buildDesert(VSWorld* world)
@@ -179,6 +188,7 @@ namespace VSTerrainGeneration
         auto chunkManager = world->getChunkManager();
         glm::ivec3 worldSize = chunkManager->getWorldSize();
         glm::ivec3 worldSizeHalf = worldSize / 2;
+        auto worldData = chunkManager->createWorldData();
         VSHeightmap desert = VSHeightmap(worldSize.y / 10, 2, 0.02F, 10.F, 0.5F, 2.F);
 
         std::random_device rd;   // Will be used to obtain a seed for the random number engine
@@ -196,18 +206,21 @@ namespace VSTerrainGeneration
 
                 for (int y = -worldSizeHalf.y; y < height - worldSizeHalf.y; y++)
                 {
-                    chunkManager->setBlock({x, y, z}, blockID);
+                    worldData.setBlock({x, y, z}, blockID);
                 }
                 if (tree == 0)
                 {
                     if (x > -worldSizeHalf.x + 1 && z > -worldSizeHalf.z + 1 &&
                         x < worldSizeHalf.x - 3 && z < worldSizeHalf.z - 3)
                     {
-                        cactusAt(world, x, height - worldSizeHalf.y, z);
+                        cactusAt(worldData, x, height - worldSizeHalf.y, z);
                     }
                 }
             }
         }
+
+        // the main thread swaps the blocks in between frames
+        chunkManager->setWorldData(std::move(worldData));
     }
 
     void buildEditorPlane(VSWorld* world)
@@ -216,19 +229,17 @@ namespace VSTerrainGeneration
         glm::ivec3 worldSize = chunkManager->getWorldSize();
         glm::ivec3 worldSizeHalf = worldSize / 2;
 
-        for (int x = -worldSizeHalf.x; x < worldSizeHalf.x; x++)
-        {
-            for (int z = -worldSizeHalf.z; z < worldSizeHalf.z; z++)
-            {
-                chunkManager->setBlock({x, 0, z}, 1);
-            }
-        }
+        chunkManager->enqueueFillBox(
+            {-worldSizeHalf.x, 0, -worldSizeHalf.z}, {worldSizeHalf.x, 1, worldSizeHalf.z}, 1);
     }
 
-    void placeModelAt(VSWorld* world, VSChunkManager::VSBuildingData build, int i, int j, int k)
+    void placeModelAt(
+        VSChunkManager::VSWorldData& worldData,
+        VSChunkManager::VSBuildingData build,
+        int i,
+        int j,
+        int k)
     {
-        auto chunkManager = world->getChunkManager();
-
         const glm::vec2 boundsXZ = {(glm::vec3(build.buildSize) / 2.F).x,
                                     (glm::vec3(build.buildSize) / 2.F).z};
 
@@ -240,68 +251,64 @@ namespace VSTerrainGeneration
                 {
                     const auto currentBlockWorldLocation = glm::vec3{x, y, z} + glm::vec3{i, j, k} -
                                           glm::vec3(-boundsXZ.x, 1, -boundsXZ.y);
-                    if (chunkManager->isLocationInBounds(currentBlockWorldLocation))
-                    {
-                        chunkManager->setBlock(currentBlockWorldLocation,
-                            build.blocks
-                                [x + y * build.buildSize.x +
-                                 z * build.buildSize.x * build.buildSize.y]);
-                    }
+                    // blocks outside of the world are skipped
+                    worldData.setBlock(
+                        currentBlockWorldLocation,
+                        build.blocks
+                            [x + y * build.buildSize.x +
+                             z * build.buildSize.x * build.buildSize.y]);
                 }
             }
         }
     }
 
-    void treeAt(VSWorld* world, int x, int y, int z)
+    void treeAt(VSChunkManager::VSWorldData& worldData, int x, int y, int z)
     {
-        auto chunkManager = world->getChunkManager();
-        chunkManager->setBlock({x, y, z}, 4);
-        chunkManager->setBlock({x, y + 1, z}, 4);
-        chunkManager->setBlock({x, y + 2, z}, 4);
-        chunkManager->setBlock({x, y + 3, z}, 4);
-        chunkManager->setBlock({x + 1, y + 3, z}, 6);
-        chunkManager->setBlock({x - 1, y + 3, z}, 6);
-        chunkManager->setBlock({x, y + 3, z + 1}, 6);
-        chunkManager->setBlock({x, y + 3, z - 1}, 6);
-        chunkManager->setBlock({x + 1, y + 3, z + 1}, 6);
-        chunkManager->setBlock({x - 1, y + 3, z - 1}, 6);
-        chunkManager->setBlock({x + 1, y + 3, z - 1}, 6);
-        chunkManager->setBlock({x - 1, y + 3, z + 1}, 6);
-        chunkManager->setBlock({x, y + 4, z}, 6);
+        worldData.setBlock({x, y, z}, 4);
+        worldData.setBlock({x, y + 1, z}, 4);
+        worldData.setBlock({x, y + 2, z}, 4);
+        worldData.setBlock({x, y + 3, z}, 4);
+        worldData.setBlock({x + 1, y + 3, z}, 6);
+        worldData.setBlock({x - 1, y + 3, z}, 6);
+        worldData.setBlock({x, y + 3, z + 1}, 6);
+        worldData.setBlock({x, y + 3, z - 1}, 6);
+        worldData.setBlock({x + 1, y + 3, z + 1}, 6);
+        worldData.setBlock({x - 1, y + 3, z - 1}, 6);
+        worldData.setBlock({x + 1, y + 3, z - 1}, 6);
+        worldData.setBlock({x - 1, y + 3, z + 1}, 6);
+        worldData.setBlock({x, y + 4, z}, 6);
     }
 
-    void birchtreeAt(VSWorld* world, int x, int y, int z)
+    void birchtreeAt(VSChunkManager::VSWorldData& worldData, int x, int y, int z)
     {
-        auto chunkManager = world->getChunkManager();
-        chunkManager->setBlock({x, y, z}, 22);
-        chunkManager->setBlock({x, y + 1, z}, 22);
-        chunkManager->setBlock({x, y + 2, z}, 22);
-        chunkManager->setBlock({x, y + 3, z}, 22);
-        chunkManager->setBlock({x + 1, y + 3, z}, 6);
-        chunkManager->setBlock({x - 1, y + 3, z}, 6);
-        chunkManager->setBlock({x, y + 3, z + 1}, 6);
-        chunkManager->setBlock({x, y + 3, z - 1}, 6);
-        chunkManager->setBlock({x + 1, y + 3, z + 1}, 6);
-        chunkManager->setBlock({x - 1, y + 3, z - 1}, 6);
-        chunkManager->setBlock({x + 1, y + 3, z - 1}, 6);
-        chunkManager->setBlock({x - 1, y + 3, z + 1}, 6);
-        chunkManager->setBlock({x, y + 4, z}, 6);
+        worldData.setBlock({x, y, z}, 22);
+        worldData.setBlock({x, y + 1, z}, 22);
+        worldData.setBlock({x, y + 2, z}, 22);
+        worldData.setBlock({x, y + 3, z}, 22);
+        worldData.setBlock({x + 1, y + 3, z}, 6);
+        worldData.setBlock({x - 1, y + 3, z}, 6);
+        worldData.setBlock({x, y + 3, z + 1}, 6);
+        worldData.setBlock({x, y + 3, z - 1}, 6);
+        worldData.setBlock({x + 1, y + 3, z + 1}, 6);
+        worldData.setBlock({x - 1, y + 3, z - 1}, 6);
+        worldData.setBlock({x + 1, y + 3, z - 1}, 6);
+        worldData.setBlock({x - 1, y + 3, z + 1}, 6);
+        worldData.setBlock({x, y + 4, z}, 6);
     }
 
-    void cactusAt(VSWorld* world, int x, int y, int z)
+    void cactusAt(VSChunkManager::VSWorldData& worldData, int x, int y, int z)
     {
-        auto chunkManager = world->getChunkManager();
-        chunkManager->setBlock({x, y, z}, 8);
-        chunkManager->setBlock({x, y + 1, z}, 8);
-        chunkManager->setBlock({x, y + 2, z}, 8);
-        chunkManager->setBlock({x, y + 3, z}, 8);
-        chunkManager->setBlock({x, y + 4, z}, 8);
-        chunkManager->setBlock({x, y + 5, z}, 8);
-        chunkManager->setBlock({x, y + 1, z + 1}, 8);
-        chunkManager->setBlock({x, y + 1, z + 2}, 8);
-        chunkManager->setBlock({x, y + 2, z + 2}, 8);
-        chunkManager->setBlock({x, y + 2, z - 1}, 8);
-        chunkManager->setBlock({x, y + 2, z - 2}, 8);
-        chunkManager->setBlock({x, y + 3, z - 2}, 8);
+        worldData.setBlock({x, y, z}, 8);
+        worldData.setBlock({x, y + 1, z}, 8);
+        worldData.setBlock({x, y + 2, z}, 8);
+        worldData.setBlock({x, y + 3, z}, 8);
+        worldData.setBlock({x, y + 4, z}, 8);
+        worldData.setBlock({x, y + 5, z}, 8);
+        worldData.setBlock({x, y + 1, z + 1}, 8);
+        worldData.setBlock({x, y + 1, z + 2}, 8);
+        worldData.setBlock({x, y + 2, z + 2}, 8);
+        worldData.setBlock({x, y + 2, z - 1}, 8);
+        worldData.setBlock({x, y + 2, z - 2}, 8);
+        worldData.setBlock({x, y + 3, z - 2}, 8);
     }
 }  // namespace VSTerrainGeneration
\ No newline at end of file
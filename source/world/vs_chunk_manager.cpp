@@ -12,13 +12,18 @@
 #include <numeric>
 #include <array>
 #include <glm/gtx/norm.hpp>
+#include <glm/vector_relational.hpp>
 #include <vector>
 #include <functional>
+#include <thread>
 
 #include "renderer/vs_modelloader.h"
 #include "renderer/vs_textureloader.h"
 
 #include "world/vs_block.h"
+#include "world/vs_distance_transform.h"
+#include "world/vs_face_light.h"
+#include "world/vs_face_masks.h"
 #include "world/vs_world.h"
 
 #include "core/vs_camera.h"
@@ -38,115 +43,137 @@ enum VSCubeFace : std::uint8_t
     Back = 4
 };
 
-VSChunkManager::VSChunkManager()
+// offsets of the 6 blocks sharing a face with a block
+const std::array<glm::ivec3, 6> neighbourDirections = {
+    glm::ivec3(1, 0, 0),
+    glm::ivec3(-1, 0, 0),
+    glm::ivec3(0, 1, 0),
+    glm::ivec3(0, -1, 0),
+    glm::ivec3(0, 0, 1),
+    glm::ivec3(0, 0, -1)};
+
+// bits needed to store values in [0, count)
+std::uint32_t getBitCount(std::size_t count)
+{
+    std::uint32_t bitCount = 1;
+    while ((std::size_t{1} << bitCount) < count)
+    {
+        bitCount++;
+    }
+    return bitCount;
+}
+
+// index of the chunk at offset in a 3x3x3 neighbourhood, see VSSnapshotSources
+std::size_t getNeighbourhoodIndex(const glm::ivec3& offset)
+{
+    return static_cast<std::size_t>((offset.x + 1) + (offset.y + 1) * 3 + (offset.z + 1) * 9);
+}
+
+// room for a face combination, a few instances more than it has so partial updates fit
+std::size_t getInstanceCapacity(std::size_t instanceCount)
+{
+    return instanceCount + instanceCount / 8 + 2;
+}
+
+VSChunkManager::VSChunkManager(VSChunkMeshingMode meshingMode)
+    : meshingMode(meshingMode)
+    , chunkShader(
+          meshingMode == VSChunkMeshingMode::Greedy
+              ? VSShader("Chunk", false, {"VS_GREEDY_MESHING"})
+              : VSShader("Chunk"))
 {
     spriteTextureID = 0;
     shadowTextureID = 1;
+    chunkLocationTextureID = 2;
+    shadowBrickTableID = 3;
 
-    for (std::size_t i = 1; i < 64; i++)
+    if (meshingMode == VSChunkMeshingMode::Greedy)
     {
-        auto* vertexContext =
-            loadVertexContext("resources/models/cubes/" + std::to_string(i) + ".obj");
-        vertexContexts[i] = vertexContext;
-
-        glBindVertexArray(vertexContext->vertexArrayObject);
+        meshArena = std::make_unique<VSBufferArena>(
+            GL_ARRAY_BUFFER, sizeof(VSChunk::VSMeshVertex), initialMeshArenaCapacity);
 
-        auto nextAttribPointer = vertexContext->lastAttribPointer + 1;
-        glGenBuffers(1, &visibleBlockInfoBuffers[i]);
-        glBindBuffer(GL_ARRAY_BUFFER, visibleBlockInfoBuffers[i]);
+        glGenVertexArrays(1, &meshVertexArrayObject);
+        glBindVertexArray(meshVertexArrayObject);
+        for (GLuint attribPointer = 0; attribPointer < 4; attribPointer++)
+        {
+            glEnableVertexAttribArray(attribPointer);
+        }
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribPointer(
-            nextAttribPointer,
-            3,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, locationWorldSpace));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        glGenBuffers(1, &quadIndexBuffer);
+        ensureQuadIndexCapacity(initialQuadIndexCapacity);
 
-        nextAttribPointer++;
+        glBindVertexArray(0);
+    }
+    else
+    {
+        instanceArena = std::make_unique<VSBufferArena>(
+            GL_ARRAY_BUFFER, sizeof(VSChunk::VSVisibleBlockInfo), initialInstanceArenaCapacity);
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_BYTE,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, id));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        std::vector<VSVertexData> cubeVertexData;
+        std::vector<GLuint> cubeTriangleIndices;
 
-        nextAttribPointer++;
+        for (std::size_t i = 1; i < faceCombinationCount; i++)
+        {
+            const auto baseVertex = cubeVertexData.size();
+            const auto firstIndex = cubeTriangleIndices.size();
+
+            loadVertexData(
+                "resources/models/cubes/" + std::to_string(i) + ".obj",
+                cubeVertexData,
+                cubeTriangleIndices);
+
+            cubeMeshRanges[i] = {
+                static_cast<GLuint>(firstIndex),
+                static_cast<GLuint>(cubeTriangleIndices.size() - firstIndex),
+                static_cast<GLint>(baseVertex),
+                static_cast<GLuint>(cubeVertexData.size() - baseVertex)};
+        }
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_INT,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, lightRight));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        cubeVertexContext = new VSVertexContext(cubeVertexData, cubeTriangleIndices);
 
-        nextAttribPointer++;
+        glBindVertexArray(cubeVertexContext->vertexArrayObject);
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_INT,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, lightLeft));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        const auto firstInstanceAttribPointer = cubeVertexContext->lastAttribPointer + 1;
+        for (GLuint attribPointer = firstInstanceAttribPointer;
+             attribPointer < firstInstanceAttribPointer + instanceAttribCount;
+             attribPointer++)
+        {
+            glEnableVertexAttribArray(attribPointer);
+            glVertexAttribDivisor(attribPointer, 1);
+        }
 
-        nextAttribPointer++;
+        int maxAttribs = 256;
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttribs);
+        assert(static_cast<int>(firstInstanceAttribPointer + instanceAttribCount) <= maxAttribs);
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_INT,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, lightTop));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        glBindVertexArray(0);
+    }
 
-        nextAttribPointer++;
+    glGenBuffers(1, &drawCommandBuffer);
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_INT,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, lightBottom));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+    glGenBuffers(1, &chunkLocationBuffer);
+    glGenTextures(1, &chunkLocationTexture);
 
-        nextAttribPointer++;
+    if (GLAD_GL_VERSION_4_3)
+    {
+        chunkCullShader = std::make_unique<VSShader>("ChunkCull", true);
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_INT,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, lightFront));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        glGenBuffers(1, &cullEntryBuffer);
+        glGenBuffers(1, &culledDrawCommandBuffer);
 
-        nextAttribPointer++;
+        glGenBuffers(1, &culledDrawCommandCountBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culledDrawCommandCountBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-        glEnableVertexAttribArray(nextAttribPointer);
-        glVertexAttribIPointer(
-            nextAttribPointer,
-            1,
-            GL_UNSIGNED_INT,
-            sizeof(VSChunk::VSVisibleBlockInfo),
-            (void*)offsetof(VSChunk::VSVisibleBlockInfo, lightBack));
-        glVertexAttribDivisor(nextAttribPointer, 1);
+        bCanDrawIndirectCount = GLAD_GL_VERSION_4_6;
 
-        int maxAttribs = 256;
-        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttribs);
-        assert(nextAttribPointer < maxAttribs);
+        shadowJumpFloodShader = std::make_unique<VSShader>("ShadowJumpFlood", true);
 
-        glBindVertexArray(0);
+        glGenBuffers(1, &shadowSeedBuffer);
+        glGenBuffers(jumpFloodBuffers.size(), jumpFloodBuffers.data());
+        glGenBuffers(1, &shadowBrickPageBuffer);
+        glGenBuffers(1, &shadowBrickMinDistanceBuffer);
     }
 
     std::vector<glm::vec3> blockColors = {
@@ -163,322 +190,1167 @@ VSChunkManager::VSChunkManager()
 
     chunkShader.uniforms()
         .setVec3Array("blockColors", blockColors)
-        .setInt("spriteTexture", spriteTextureID);
+        .setInt("spriteTexture", spriteTextureID)
+        .setInt("chunkLocations", chunkLocationTextureID);
 }
 
 VSBlockID VSChunkManager::getBlock(const glm::vec3& location) const
 {
     const auto zeroBaseLocation = glm::ivec3(glm::floor(location)) + worldSizeHalf;
     const auto [chunkIndex, blockIndex] = worldCoordinatesToChunkAndBlockIndex(zeroBaseLocation);
-    return chunks[chunkIndex]->blocks[blockIndex];
+    // the main thread replaces block data that is copied on write while it is read
+    const auto blockData = std::atomic_load(&chunks[chunkIndex]->blockData);
+    return blockData->sections.getBlock(blockIndex);
+}
+
+void VSChunkManager::enqueueSetBlock(const glm::vec3& location, VSBlockID blockID)
+{
+    VSEditCommand command;
+    command.origin = glm::ivec3(glm::floor(location));
+    command.size = glm::ivec3(1);
+    command.blockID = blockID;
+    editCommands.enqueue(std::move(command));
 }
 
-void VSChunkManager::setBlock(const glm::vec3& location, VSBlockID blockID)
+void VSChunkManager::enqueueFillBox(const glm::vec3& low, const glm::vec3& high, VSBlockID blockID)
 {
-    assert(!bShouldReinitializeChunks);
-    const auto locationFloored = glm::ivec3(glm::floor(location));
-    const auto zeroBaseLocation = locationFloored + worldSizeHalf;
-    const auto [chunkCoordinates, blockIndex] =
-        worldCoordinatesToChunkCoordinatesAndBlockIndex(zeroBaseLocation);
+    VSEditCommand command;
+    command.origin = glm::ivec3(glm::floor(low));
+    command.size = glm::max(glm::ivec3(glm::ceil(high)) - command.origin, glm::ivec3(0));
+    command.blockID = blockID;
+    editCommands.enqueue(std::move(command));
+}
 
-    const auto chunkIndex = chunkCoordinatesToChunkIndex(chunkCoordinates);
+void VSChunkManager::enqueueStamp(
+    const glm::vec3& origin,
+    const glm::ivec3& size,
+    std::vector<VSBlockID> blocks,
+    bool bIsRotated)
+{
+    assert(blocks.size() == static_cast<std::size_t>(size.x * size.y * size.z));
+
+    VSEditCommand command;
+    command.origin = glm::ivec3(glm::floor(origin));
+    command.size = bIsRotated ? glm::ivec3(size.z, size.y, size.x) : size;
+    command.blocks = std::move(blocks);
+    command.bIsRotated = bIsRotated;
+    editCommands.enqueue(std::move(command));
+}
 
-    // If new block has emssion or removed block had emission
-    if (blockEmission[blockID] != 0.F ||
-        blockEmission[chunks[chunkIndex]->blocks[blockIndex]] != 0.F)
+void VSChunkManager::applyEditCommands()
+{
+    std::size_t editedBlockCount = 0;
+    VSEditCommand command;
+    while (editedBlockCount < editBlockBudget && editCommands.try_dequeue(command))
     {
-        const auto emission = blockEmission[blockID] != 0
-                                  ? blockEmission[blockID]
-                                  : blockEmission[chunks[chunkIndex]->blocks[blockIndex]];
-        // add emission or remove emission
-        const float addOrRemove = blockEmission[blockID] != 0.F ? 1 : -1;
-        const int ceiledEmission = glm::ceil(emission);
+        const auto& size = command.size;
+        editedBlockCount += static_cast<std::size_t>(size.x) * size.y * size.z;
+
+        const auto zeroBaseOrigin = command.origin + worldSizeHalf;
+        if (command.blocks.empty())
+        {
+            editBlocks(
+                zeroBaseOrigin,
+                size,
+                [blockID = command.blockID](const glm::ivec3&) { return blockID; });
+            continue;
+        }
+
+        // stamps index their blocks in the unrotated layout
+        const auto& blocks = command.blocks;
+        const auto stampSize = command.bIsRotated ? glm::ivec3(size.z, size.y, size.x) : size;
+        editBlocks(
+            zeroBaseOrigin,
+            size,
+            [&blocks, &stampSize, bIsRotated = command.bIsRotated](const glm::ivec3& offset)
+            {
+                const auto stampCoordinates =
+                    bIsRotated ? glm::ivec3(offset.z, offset.y, offset.x) : offset;
+                return blocks
+                    [stampCoordinates.x + stampCoordinates.y * stampSize.x +
+                     stampCoordinates.z * stampSize.x * stampSize.y];
+            });
+    }
+}
+
+void VSChunkManager::editBlocks(
+    const glm::ivec3& zeroBaseOrigin,
+    const glm::ivec3& size,
+    const std::function<VSBlockID(const glm::ivec3&)>& getBlockID)
+{
+    // block data frozen from here on is not written anymore by this edit
+    editEpoch++;
 
-        for (int x = locationFloored.x - ceiledEmission; x <= locationFloored.x + ceiledEmission;
-             x++)
+    for (int z = 0; z < size.z; z++)
+    {
+        for (int y = 0; y < size.y; y++)
         {
-            for (int y = locationFloored.y - ceiledEmission;
-                 y <= locationFloored.y + ceiledEmission;
-                 y++)
+            for (int x = 0; x < size.x; x++)
             {
-                for (int z = locationFloored.z - ceiledEmission;
-                     z <= locationFloored.z + ceiledEmission;
-                     z++)
+                const auto offset = glm::ivec3(x, y, z);
+                const auto zeroBaseLocation = zeroBaseOrigin + offset;
+                if (!isZeroBaseLocationInBounds(zeroBaseLocation))
                 {
-                    const auto neighbourLocation = glm::vec3(x, y, z);
+                    continue;
+                }
 
-                    if (isLocationInBounds(neighbourLocation))
-                    {
-                        const auto distance =
-                            glm::length(glm::vec3(locationFloored) - neighbourLocation) + 0.0001F;
-                        if (distance < ceiledEmission)
-                        {
-                            addEmission(
-                                neighbourLocation,
-                                addOrRemove * 32.f * (1 - (distance / ceiledEmission)));
-                        }
-                    }
+                const auto [chunkCoordinates, blockIndex] =
+                    worldCoordinatesToChunkCoordinatesAndBlockIndex(zeroBaseLocation);
+                const auto chunkIndex = chunkCoordinatesToChunkIndex(chunkCoordinates);
+                const auto blockID = getBlockID(offset);
+                if (chunks[chunkIndex]->blockData->sections.getBlock(blockIndex) == blockID)
+                {
+                    continue;
                 }
+
+                auto* const blockData = getWritableBlockData(chunkIndex);
+                blockData->sections.setBlock(blockIndex, blockID);
+                setOccupancy(blockData, blockIndex, blockID);
+
+                const auto blockCoordinates = blockIndexToBlockCoordinates(blockIndex);
+                updateHeightmap(chunks[chunkIndex], blockCoordinates);
+                editChangedRegions[chunkIndex].add({blockCoordinates, blockCoordinates});
+                editChangedLocations.push_back(zeroBaseLocation);
             }
         }
     }
 
-    chunks[chunkIndex]->blocks[blockIndex] = blockID;
-    chunks[chunkIndex]->bIsDirty = true;
+    std::vector<glm::ivec2> changedChunkColumns;
+    for (const auto& [chunkIndex, region] : editChangedRegions)
+    {
+        const auto chunkCoordinates = chunkIndexToChunkCoordinates(chunkIndex);
+        markRegionNeighbourhoodDirty(chunkCoordinates, region);
+
+        const auto chunkColumn = glm::ivec2(chunkCoordinates.x, chunkCoordinates.z);
+        if (std::find(changedChunkColumns.begin(), changedChunkColumns.end(), chunkColumn) ==
+            changedChunkColumns.end())
+        {
+            changedChunkColumns.push_back(chunkColumn);
+        }
+    }
+    editChangedRegions.clear();
+
+    publishColumnSurfaces(changedChunkColumns);
 
-    // TODO we only need to update adjacent chunks if set block is at chunkborder
-    const auto right = glm::clamp(chunkCoordinates + glm::ivec2(1, 0), {0, 0}, chunkCount - 1);
-    const auto left = glm::clamp(chunkCoordinates - glm::ivec2(1, 0), {0, 0}, chunkCount - 1);
+    // the light is spread once for the whole edit after all heightmaps are up to date
+    for (const auto& zeroBaseLocation : editChangedLocations)
+    {
+        queueLightUpdate(zeroBaseLocation);
+    }
+    editChangedLocations.clear();
 
-    const auto top = glm::clamp(chunkCoordinates + glm::ivec2(0, 1), {0, 0}, chunkCount - 1);
-    const auto down = glm::clamp(chunkCoordinates - glm::ivec2(1, 0), {0, 0}, chunkCount - 1);
+    propagateLight(BlockLight);
+    propagateLight(SkyLight);
 
-    chunks[chunkCoordinatesToChunkIndex(right)]->bIsDirty = true;
-    chunks[chunkCoordinatesToChunkIndex(left)]->bIsDirty = true;
-    chunks[chunkCoordinatesToChunkIndex(top)]->bIsDirty = true;
-    chunks[chunkCoordinatesToChunkIndex(down)]->bIsDirty = true;
+    editEpoch++;
 }
 
-void VSChunkManager::addEmission(const glm::vec3& location, float emission)
+std::shared_ptr<VSChunkManager::VSChunk::VSBlockData> VSChunkManager::createBlockData() const
 {
-    const auto locationFloored = glm::ivec3(glm::floor(location));
-    const auto zeroBaseLocation = locationFloored + worldSizeHalf;
-    const auto [chunkIndex, blockIndex] = worldCoordinatesToChunkAndBlockIndex(zeroBaseLocation);
+    auto* const memory = chunkMemory.getResource();
+    return std::allocate_shared<VSChunk::VSBlockData>(
+        std::pmr::polymorphic_allocator<VSChunk::VSBlockData>(memory), memory);
+}
 
-    chunks[chunkIndex]->bIsDirty = true;
-    chunks[chunkIndex]->lightLevel[blockIndex] += emission;
+std::shared_ptr<VSChunkManager::VSChunk::VSBlockVisibility>
+VSChunkManager::createBlockVisibility() const
+{
+    // the vector picks up the resource of the allocator it is constructed with
+    return std::allocate_shared<VSChunk::VSBlockVisibility>(
+        std::pmr::polymorphic_allocator<VSChunk::VSBlockVisibility>(chunkMemory.getResource()));
 }
 
-glm::ivec3 VSChunkManager::getWorldSize() const
+VSChunkManager::VSChunk::VSBlockData* VSChunkManager::getWritableBlockData(std::size_t chunkIndex)
 {
-    return worldSize;
+    auto* const chunk = chunks[chunkIndex];
+    if (chunk->blockData->bIsFrozen)
+    {
+        // readers keep the frozen version, the edit continues on a copy
+        const auto& frozenBlockData = *chunk->blockData;
+        auto blockData = createBlockData();
+        blockData->sections = frozenBlockData.sections;
+        blockData->occupancy = frozenBlockData.occupancy;
+        // sections that lost block ids in earlier edits get smaller indices
+        blockData->sections.compact();
+        std::atomic_store(&chunk->blockData, std::move(blockData));
+    }
+    return chunk->blockData.get();
 }
 
-glm::ivec2 VSChunkManager::getChunkCount() const
+std::shared_ptr<const VSChunkManager::VSChunk::VSBlockData>
+VSChunkManager::freezeBlockData(std::size_t chunkIndex) const
 {
-    return chunkCount;
+    auto blockData = std::atomic_load(&chunks[chunkIndex]->blockData);
+    if (!blockData->bIsFrozen.exchange(true))
+    {
+        // an edit that started before the freeze can still write this version, wait for it
+        const auto epoch = editEpoch.load();
+        while (epoch % 2 == 1 && editEpoch.load() == epoch)
+        {
+            std::this_thread::yield();
+        }
+    }
+    return blockData;
 }
 
-void VSChunkManager::draw(VSWorld* world)
+void VSChunkManager::queueLightUpdate(const glm::ivec3& zeroBaseLocation)
 {
-    std::array<std::size_t, faceCombinationCount> visibleBlockInfoCount{};
-    std::array<std::size_t, faceCombinationCount> visibleBlockInfoCopiedCount{};
-    std::vector<VSChunk*> visibleChunks;
-    drawnBlockCount = 0;
+    const auto [chunkIndex, blockIndex] = worldCoordinatesToChunkAndBlockIndex(zeroBaseLocation);
+    const auto blockID = chunks[chunkIndex]->blockData->sections.getBlock(blockIndex);
+
+    // the sky lights all air above the surface at full level
+    const auto bIsOpenToSky =
+        zeroBaseLocation.y > getColumnHeight({zeroBaseLocation.x, zeroBaseLocation.z});
 
-    for (auto* chunk : chunks)
+    for (const auto channel : {BlockLight, SkyLight})
     {
-        if (VSApp::getInstance()->getUI()->getState()->bShouldDrawChunkBorder)
+        // the old light is taken back first, light from other sources is restored by the removal
+        const auto oldLight = chunks[chunkIndex]->blockData->getLight(channel, blockIndex);
+        if (oldLight != 0)
         {
-            const auto chunkPos = chunk->chunkLocation;
-            world->getDebugDraw()->drawBox(
-                {chunkPos - glm::vec3(chunkSize / 2), chunkPos + glm::vec3(chunkSize / 2)},
-                {255, 0, 0});
-
-            world->getDebugDraw()->drawSphere({0, 0, 0}, worldSizeHalf.x, {255, 0, 0});
+            setLight(channel, chunkIndex, blockIndex, 0);
+            lightRemoveQueues[channel].push({zeroBaseLocation, oldLight});
         }
 
-        glm::mat4 VP = world->getCamera()->getVPMatrix();
-        glm::vec3 cameraPos = world->getCamera()->getPosition();
-        if (VSApp::getInstance()->getUI()->getState()->bShouldFreezeFrustum)
+        const auto sourceLight = channel == BlockLight ? blockEmission[blockID]
+                                 : bIsOpenToSky        ? maxLight
+                                                       : std::uint8_t{0};
+        if (sourceLight != 0)
         {
-            VP = frozenVPMatrix;
-            cameraPos = frozenCameraPos;
-            world->getDebugDraw()->drawFrustum(VP, {0, 255, 0});
+            setLight(channel, chunkIndex, blockIndex, sourceLight);
+            lightAddQueues[channel].push({zeroBaseLocation, sourceLight});
         }
-        frozenVPMatrix = VP;
-        frozenCameraPos = cameraPos;
-
-        const auto radius = glm::length(glm::vec3(chunkSize));
-
-        auto zFar = world->getCamera()->getZFar();
 
-        // First to cheap distance check based on zFar
-        if (glm::length2(cameraPos - chunk->chunkLocation) - (radius * radius * 4.F) <
-            (zFar * zFar))
+        // removed blocks let the light of their neighbours through
+        if (blockID == VS_DEFAULT_BLOCK_ID)
         {
-            // Cull using bounding sphere in projections space
-            const auto chunkCenterInP = VP * glm::vec4(chunk->chunkLocation, 1.f);
-
-            if (!bIsFrustumCullingEnabled ||
-                ((glm::abs(chunkCenterInP.x) - radius) < (chunkCenterInP.w * 1.F) &&
-                 (glm::abs(chunkCenterInP.y) - radius) < (chunkCenterInP.w * 1.F)))
+            for (const auto& direction : neighbourDirections)
             {
-                for (std::size_t i = 0; i < chunk->visibleBlockInfos.size(); i++)
+                const auto neighbourLocation = zeroBaseLocation + direction;
+                if (isZeroBaseLocationInBounds(neighbourLocation))
                 {
-                    visibleBlockInfoCount[i] += chunk->visibleBlockInfos[i].size();
-                    drawnBlockCount += chunk->visibleBlockInfos[i].size();
+                    const auto [neighbourChunkIndex, neighbourBlockIndex] =
+                        worldCoordinatesToChunkAndBlockIndex(neighbourLocation);
+                    const auto neighbourLight = chunks[neighbourChunkIndex]->blockData->getLight(
+                        channel, neighbourBlockIndex);
+                    if (neighbourLight > 1)
+                    {
+                        lightAddQueues[channel].push({neighbourLocation, neighbourLight});
+                    }
                 }
-                visibleChunks.push_back(chunk);
             }
         }
     }
-    glActiveTexture(GL_TEXTURE0 + shadowTextureID);
-    glBindTexture(GL_TEXTURE_3D, shadowTexture);
-
-    glActiveTexture(GL_TEXTURE0 + spriteTextureID);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, spriteTexture);
-
-    chunkShader.uniforms()
-        .setVec3("lightDir", world->getDirectLightDir())
-        .setVec3("lightColor", world->getDirectLightColor())
-        .setVec3("viewPos", world->getCamera()->getPosition())
-        .setVec3("origin", origin)
-        .setVec3("colorOverride", colorOverride)
-        .setMat4("VP", world->getCamera()->getVPMatrix())
-        .setUVec3("worldSize", getWorldSize())
-        .setInt("shadowTexture", shadowTextureID)
-        .setInt("spriteTexture", spriteTextureID)
-        .setFloat(
-            "time",
-            std::chrono::duration_cast<std::chrono::duration<float>>(
-                VSApp::getInstance()->getInstance()->getStartTime() -
-                std::chrono::high_resolution_clock::now())
-                .count())
-        .setBool("enableShadows", VSApp::getInstance()->getUI()->getState()->bAreShadowsEnabled)
-        .setBool("enableAO", VSApp::getInstance()->getUI()->getState()->bIsAmbientOcclusionEnabled)
-        .setBool("showAO", VSApp::getInstance()->getUI()->getState()->bShouldShowAO)
-        .setBool("showUV", VSApp::getInstance()->getUI()->getState()->bShouldShowUV)
-        .setBool("showNormals", VSApp::getInstance()->getUI()->getState()->bShouldShowNormals)
-        .setBool("showLight", VSApp::getInstance()->getUI()->getState()->bShouldShowLight);
-
-    drawCallCount = 0;
+}
 
-    for (std::size_t i = 1; i < faceCombinationCount; i++)
+void VSChunkManager::rebuildLight()
+{
+    for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
     {
-        // dont draw if no blocks active
-        if (visibleBlockInfoCount[i] != 0)
-        {
-            glBindVertexArray(vertexContexts[i]->vertexArrayObject);
+        const auto chunkOrigin = chunkIndexToChunkCoordinates(chunkIndex) * chunkSize;
 
-            glBindBuffer(GL_ARRAY_BUFFER, visibleBlockInfoBuffers[i]);
-            glBufferData(
-                GL_ARRAY_BUFFER,
-                visibleBlockInfoCount[i] * sizeof(VSChunk::VSVisibleBlockInfo),
-                nullptr,
-                GL_DYNAMIC_DRAW);
+        // chunk local heights of the columns, chunks above can cover the whole chunk
+        std::vector<int> columnHeights(chunkSize.x * chunkSize.z);
+        for (int z = 0; z < chunkSize.z; z++)
+        {
+            for (int x = 0; x < chunkSize.x; x++)
+            {
+                columnHeights[x + z * chunkSize.x] =
+                    getColumnHeight({chunkOrigin.x + x, chunkOrigin.z + z}) - chunkOrigin.y;
+            }
+        }
 
-            for (const auto* chunk : visibleChunks)
+        auto& sections = getWritableBlockData(chunkIndex)->sections;
+        const auto [lowestColumn, highestColumn] =
+            std::minmax_element(columnHeights.begin(), columnHeights.end());
+        const auto skyLight = static_cast<std::uint8_t>(maxLight << (SkyLight * 4));
+        for (std::size_t sectionIndex = 0; sectionIndex < sections.getSectionCount();
+             sectionIndex++)
+        {
+            const auto sectionMinY =
+                static_cast<int>(sectionIndex) * VSChunkSections::sectionHeight;
+            const auto sectionMaxY =
+                glm::min(sectionMinY + VSChunkSections::sectionHeight, chunkSize.y) - 1;
+
+            // sections of one block without emission above or below all columns are lit as a
+            // whole
+            if (sections.isSectionUniform(sectionIndex) &&
+                blockEmission[sections.getSectionBlock(sectionIndex)] == 0)
             {
-                glBufferSubData(
-                    GL_ARRAY_BUFFER,
-                    visibleBlockInfoCopiedCount[i] * sizeof(VSChunk::VSVisibleBlockInfo),
-                    chunk->visibleBlockInfos[i].size() * sizeof(VSChunk::VSVisibleBlockInfo),
-                    chunk->visibleBlockInfos[i].data());
+                if (sectionMinY > *highestColumn)
+                {
+                    sections.setSectionLight(sectionIndex, skyLight);
+                    continue;
+                }
+                if (sectionMaxY <= *lowestColumn)
+                {
+                    sections.setSectionLight(sectionIndex, 0);
+                    continue;
+                }
+            }
 
-                visibleBlockInfoCopiedCount[i] += chunk->visibleBlockInfos[i].size();
+            for (int z = 0; z < chunkSize.z; z++)
+            {
+                for (int y = sectionMinY; y <= sectionMaxY; y++)
+                {
+                    for (int x = 0; x < chunkSize.x; x++)
+                    {
+                        const auto blockIndex = blockCoordinatesToBlockIndex({x, y, z});
+                        const auto emission = blockEmission[sections.getBlock(blockIndex)];
+                        const auto bIsOpenToSky = y > columnHeights[x + z * chunkSize.x];
+                        sections.setLight(
+                            blockIndex,
+                            static_cast<std::uint8_t>(
+                                (emission << (BlockLight * 4)) | (bIsOpenToSky ? skyLight : 0)));
+                        if (emission != 0)
+                        {
+                            lightAddQueues[BlockLight].push(
+                                {chunkOrigin + glm::ivec3(x, y, z), emission});
+                        }
+                    }
+                }
             }
+        }
 
-            glDrawElementsInstanced(
-                GL_TRIANGLES,
-                vertexContexts[i]->indexCount,
-                GL_UNSIGNED_INT,
-                nullptr,
-                visibleBlockInfoCount[i]);
+        for (int z = 0; z < chunkSize.z; z++)
+        {
+            for (int x = 0; x < chunkSize.x; x++)
+            {
+                const int height = columnHeights[x + z * chunkSize.x];
+
+                // only open blocks next to a higher column can light blocks below the surface
+                const auto column = glm::ivec2(chunkOrigin.x + x, chunkOrigin.z + z);
+                int maxNeighbourHeight = height;
+                for (const auto& offset :
+                     {glm::ivec2(1, 0), glm::ivec2(-1, 0), glm::ivec2(0, 1), glm::ivec2(0, -1)})
+                {
+                    const auto neighbourColumn = column + offset;
+                    if (isZeroBaseLocationInBounds({neighbourColumn.x, 0, neighbourColumn.y}))
+                    {
+                        maxNeighbourHeight = glm::max(
+                            maxNeighbourHeight, getColumnHeight(neighbourColumn) - chunkOrigin.y);
+                    }
+                }
 
-            drawCallCount++;
+                for (int y = glm::max(height + 1, 0);
+                     y <= glm::min(maxNeighbourHeight, chunkSize.y - 1);
+                     y++)
+                {
+                    lightAddQueues[SkyLight].push(
+                        {{column.x, chunkOrigin.y + y, column.y}, maxLight});
+                }
+            }
         }
     }
 
-    glBindVertexArray(0);
+    propagateLight(BlockLight);
+    propagateLight(SkyLight);
 }
 
-void VSChunkManager::updateChunks()
+void VSChunkManager::propagateLight(VSLightChannel channel)
 {
-    assert(debug_isMainThread());
-
-    initializeChunks();
+    const auto down = glm::ivec3(0, -1, 0);
+    auto& removeQueue = lightRemoveQueues[channel];
+    auto& addQueue = lightAddQueues[channel];
 
-    // Init from file asynchronous
-    bool expected = true;
-    if (!bShouldReinitializeChunks &&
-        bShouldInitializeFromData.compare_exchange_weak(expected, false))
+    while (!removeQueue.empty())
     {
-        // Set block data to chunks, TODO: add checks, this is potentially dangerous
-        uint32_t chunkBlockCount = getChunkBlockCount();
-        VSLog::Log(VSLog::Category::Core, VSLog::Level::info, "cbc {}", chunkBlockCount);
+        const auto [location, light] = removeQueue.front();
+        removeQueue.pop();
 
-        auto iter = worldDataFromFile.blocks.begin();
-        for (auto* chunk : chunks)
+        for (const auto& direction : neighbourDirections)
         {
-            std::copy(iter, iter + chunkBlockCount, chunk->blocks.begin());
+            const auto neighbourLocation = location + direction;
+            if (!isZeroBaseLocationInBounds(neighbourLocation))
+            {
+                continue;
+            }
 
-            chunk->bIsDirty = true;
-            iter += chunkBlockCount;
+            const auto [neighbourChunkIndex, neighbourBlockIndex] =
+                worldCoordinatesToChunkAndBlockIndex(neighbourLocation);
+            const auto neighbourLight =
+                chunks[neighbourChunkIndex]->blockData->getLight(channel, neighbourBlockIndex);
+            const bool bIsSkyColumn = channel == SkyLight && direction == down &&
+                                      light == maxLight && neighbourLight == maxLight;
+            // dimmer neighbours were lit by the removed light, brighter ones by another source
+            if (neighbourLight != 0 && (neighbourLight < light || bIsSkyColumn))
+            {
+                setLight(channel, neighbourChunkIndex, neighbourBlockIndex, 0);
+                removeQueue.push({neighbourLocation, neighbourLight});
+            }
+            else if (neighbourLight >= light)
+            {
+                addQueue.push({neighbourLocation, neighbourLight});
+            }
         }
     }
 
-    for (std::size_t chunkIndex = 0; chunkIndex < getTotalChunkCount(); ++chunkIndex)
+    while (!addQueue.empty())
     {
-        updateVisibleBlocks(chunkIndex);
-    }
+        const auto [location, light] = addQueue.front();
+        addQueue.pop();
 
-    if (VSApp::getInstance()->getUI()->getState()->bAreShadowsEnabled)
-    {
-        for (std::size_t chunkIndex = 0; chunkIndex < getTotalChunkCount(); ++chunkIndex)
+        // the block might have been darkened or brightened since it was queued
+        const auto [chunkIndex, blockIndex] = worldCoordinatesToChunkAndBlockIndex(location);
+        if (chunks[chunkIndex]->blockData->getLight(channel, blockIndex) != light || light <= 1)
+        {
+            continue;
+        }
+
+        for (const auto& direction : neighbourDirections)
         {
-            updateShadows(chunkIndex);
+            const auto neighbourLocation = location + direction;
+            if (!isZeroBaseLocationInBounds(neighbourLocation))
+            {
+                continue;
+            }
+
+            // light only spreads through air
+            const auto [neighbourChunkIndex, neighbourBlockIndex] =
+                worldCoordinatesToChunkAndBlockIndex(neighbourLocation);
+            const auto* neighbourBlockData = chunks[neighbourChunkIndex]->blockData.get();
+            const std::uint8_t neighbourLight =
+                channel == SkyLight && direction == down && light == maxLight ? light : light - 1;
+            if (neighbourBlockData->sections.getBlock(neighbourBlockIndex) == VS_DEFAULT_BLOCK_ID &&
+                neighbourBlockData->getLight(channel, neighbourBlockIndex) < neighbourLight)
+            {
+                setLight(channel, neighbourChunkIndex, neighbourBlockIndex, neighbourLight);
+                addQueue.push({neighbourLocation, neighbourLight});
+            }
         }
     }
+
+    for (const auto& [chunkIndex, region] : lightChangedRegions)
+    {
+        markRegionNeighbourhoodDirty(chunkIndexToChunkCoordinates(chunkIndex), region);
+    }
+    lightChangedRegions.clear();
 }
 
-glm::vec3 VSChunkManager::getOrigin() const
+void VSChunkManager::setLight(
+    VSLightChannel channel,
+    std::size_t chunkIndex,
+    std::size_t blockIndex,
+    std::uint8_t light)
 {
-    return origin;
+    getWritableBlockData(chunkIndex)->setLight(channel, blockIndex, light);
+
+    const auto blockCoordinates = blockIndexToBlockCoordinates(blockIndex);
+    auto& region = lightChangedRegions[chunkIndex];
+    region.add({blockCoordinates, blockCoordinates});
 }
 
-void VSChunkManager::setOrigin(const glm::vec3& newOrigin)
+void VSChunkManager::updateHeightmap(VSChunk* chunk, const glm::ivec3& blockCoordinates) const
 {
-    origin = newOrigin;
+    auto& height = chunk->heightmap[blockCoordinates.x + blockCoordinates.z * chunkSize.x];
+    const auto& sections = chunk->blockData->sections;
+    if (sections.getBlock(blockCoordinatesToBlockIndex(blockCoordinates)) != VS_DEFAULT_BLOCK_ID)
+    {
+        height = std::max(height, static_cast<std::int16_t>(blockCoordinates.y));
+    }
+    else if (blockCoordinates.y == height)
+    {
+        // the new surface can only be below the removed block
+        do
+        {
+            height--;
+        } while (height >= 0 &&
+                 sections.getBlock(blockCoordinatesToBlockIndex(
+                     {blockCoordinates.x, height, blockCoordinates.z})) == VS_DEFAULT_BLOCK_ID);
+    }
 }
 
-bool VSChunkManager::isFrustumCullingEnabled() const
+void VSChunkManager::rebuildHeightmap(VSChunk* chunk) const
 {
-    return bIsFrustumCullingEnabled;
+    const auto& sections = chunk->blockData->sections;
+    for (int z = 0; z < chunkSize.z; z++)
+    {
+        for (int x = 0; x < chunkSize.x; x++)
+        {
+            auto& height = chunk->heightmap[x + z * chunkSize.x];
+            height = static_cast<std::int16_t>(chunkSize.y - 1);
+            while (height >= 0 &&
+                   sections.getBlock(blockCoordinatesToBlockIndex({x, height, z})) ==
+                       VS_DEFAULT_BLOCK_ID)
+            {
+                height--;
+            }
+        }
+    }
 }
 
-void VSChunkManager::setIsFrustumCullingEnabled(bool state)
+int VSChunkManager::getColumnHeight(const glm::ivec2& zeroBaseColumn) const
 {
-    bIsFrustumCullingEnabled = state;
+    const auto chunkColumn = zeroBaseColumn / glm::ivec2(chunkSize.x, chunkSize.z);
+    const auto columnCoordinates =
+        zeroBaseColumn - chunkColumn * glm::ivec2(chunkSize.x, chunkSize.z);
+    for (int chunkY = chunkCount.y - 1; chunkY >= 0; chunkY--)
+    {
+        const auto height =
+            chunks[chunkCoordinatesToChunkIndex({chunkColumn.x, chunkY, chunkColumn.y})]
+                ->heightmap[columnCoordinates.x + columnCoordinates.y * chunkSize.x];
+        if (height >= 0)
+        {
+            return chunkY * chunkSize.y + height;
+        }
+    }
+    return -1;
 }
 
-glm::vec3 VSChunkManager::getColorOverride() const
+void VSChunkManager::publishColumnSurfaces(const std::vector<glm::ivec2>& chunkColumns)
 {
-    return colorOverride;
+    auto nextSurfaces = std::make_shared<VSColumnSurfaces>();
+    nextSurfaces->chunkSize = chunkSize;
+    nextSurfaces->chunkCount = chunkCount;
+    nextSurfaces->worldSizeHalf = worldSizeHalf;
+
+    // only this thread replaces the surfaces
+    const auto& previousSurfaces = columnSurfaces;
+    if (previousSurfaces && previousSurfaces->chunkSize == chunkSize &&
+        previousSurfaces->chunkCount == chunkCount)
+    {
+        nextSurfaces->columns = previousSurfaces->columns;
+    }
+    else
+    {
+        nextSurfaces->columns.resize(chunkCount.x * chunkCount.z);
+    }
+
+    for (const auto& chunkColumn : chunkColumns)
+    {
+        auto surfaces =
+            std::make_shared<std::vector<VSColumnSurface>>(chunkSize.x * chunkSize.z);
+        const auto columnOrigin = chunkColumn * glm::ivec2(chunkSize.x, chunkSize.z);
+        for (int z = 0; z < chunkSize.z; z++)
+        {
+            for (int x = 0; x < chunkSize.x; x++)
+            {
+                auto& surface = (*surfaces)[x + z * chunkSize.x];
+                const auto zeroBaseColumn = columnOrigin + glm::ivec2(x, z);
+                surface.height = static_cast<std::int16_t>(getColumnHeight(zeroBaseColumn));
+                if (surface.height >= 0)
+                {
+                    const auto [chunkIndex, blockIndex] = worldCoordinatesToChunkAndBlockIndex(
+                        glm::ivec3(zeroBaseColumn.x, surface.height, zeroBaseColumn.y));
+                    surface.blockID =
+                        chunks[chunkIndex]->blockData->sections.getBlock(blockIndex);
+                }
+            }
+        }
+        nextSurfaces->columns[chunkColumn.x + chunkColumn.y * chunkCount.x] = std::move(surfaces);
+    }
+
+    std::atomic_store(
+        &columnSurfaces, std::shared_ptr<const VSColumnSurfaces>(std::move(nextSurfaces)));
 }
 
-void VSChunkManager::setColorOverride(const glm::vec3& newColorOverride)
+std::vector<glm::ivec2> VSChunkManager::getAllChunkColumns() const
 {
-    colorOverride = newColorOverride;
+    std::vector<glm::ivec2> chunkColumns;
+    chunkColumns.reserve(chunkCount.x * chunkCount.z);
+    for (int z = 0; z < chunkCount.z; z++)
+    {
+        for (int x = 0; x < chunkCount.x; x++)
+        {
+            chunkColumns.emplace_back(x, z);
+        }
+    }
+    return chunkColumns;
 }
 
-void VSChunkManager::setChunkDimensions(
-    const glm::ivec3& inChunkSize,
-    const glm::ivec2& inChunkCount)
+bool VSChunkManager::isZeroBaseLocationInBounds(const glm::ivec3& zeroBaseLocation) const
 {
-    // Force even number of chunks and blocks
-    newChunkSize = (inChunkSize / 2) * 2;
-    newChunkCount = (inChunkCount / 2) * 2;
-    newWorldSize = {
-        newChunkSize.x * newChunkCount.x, newChunkSize.y, newChunkSize.z * newChunkCount.y};
-    newWorldSizeHalf = newWorldSize / 2;
-    bShouldReinitializeChunks = true;
+    return glm::all(glm::greaterThanEqual(zeroBaseLocation, glm::ivec3(0))) &&
+           glm::all(glm::lessThan(zeroBaseLocation, worldSize));
 }
 
-std::size_t VSChunkManager::getChunkBlockCount() const
+glm::ivec3 VSChunkManager::getWorldSize() const
 {
-    return glm::compMul(chunkSize);
+    return worldSize;
 }
 
-std::size_t VSChunkManager::getTotalBlockCount() const
+glm::ivec3 VSChunkManager::getChunkCount() const
 {
-    return glm::compMul(chunkSize) * getTotalChunkCount();
+    return chunkCount;
 }
 
-std::size_t VSChunkManager::getVisibleBlockCount() const
+void VSChunkManager::draw(VSWorld* world)
 {
-    return std::accumulate(chunks.begin(), chunks.end(), 0, [](std::size_t acc, VSChunk* curr) {
-        return acc +
+    const auto* uiState = VSApp::getInstance()->getUI()->getState();
+
+    if (uiState->bShouldDrawChunkBorder)
+    {
+        for (const auto* chunk : chunks)
+        {
+            const auto chunkPos = chunk->chunkLocation;
+            world->getDebugDraw()->drawBox(
+                {chunkPos - glm::vec3(chunkSize / 2), chunkPos + glm::vec3(chunkSize / 2)},
+                {255, 0, 0});
+        }
+
+        world->getDebugDraw()->drawSphere({0, 0, 0}, worldSizeHalf.x, {255, 0, 0});
+    }
+
+    glm::mat4 VP = world->getCamera()->getVPMatrix();
+    glm::vec3 cameraPos = world->getCamera()->getPosition();
+    if (uiState->bShouldFreezeFrustum)
+    {
+        VP = frozenVPMatrix;
+        cameraPos = frozenCameraPos;
+        world->getDebugDraw()->drawFrustum(VP, {0, 255, 0});
+    }
+    frozenVPMatrix = VP;
+    frozenCameraPos = cameraPos;
+
+    const auto radius = glm::length(glm::vec3(chunkSize));
+
+    const auto zFar = world->getCamera()->getZFar();
+
+    // compute shaders need GL 4.3
+    const bool bShouldCullOnGPU = uiState->chunkDrawMode == 2 && chunkCullShader != nullptr;
+
+    std::vector<VSChunk*> visibleChunks;
+    drawnBlockCount = 0;
+    drawnTriangleCount = 0;
+    drawnVertexCount = 0;
+
+    if (bShouldCullOnGPU)
+    {
+        // culling results stay on the GPU, so this is an upper bound
+        for (const auto* chunk : chunks)
+        {
+            for (const auto& visibleBlockInfos : chunk->visibleBlockInfos)
+            {
+                drawnBlockCount += visibleBlockInfos.size();
+            }
+            drawnTriangleCount += chunk->triangleCount;
+            drawnVertexCount += chunk->vertexCount;
+        }
+
+        cullChunksOnGPU(VP, cameraPos, zFar, radius);
+    }
+    else
+    {
+        for (auto* chunk : chunks)
+        {
+            // First to cheap distance check based on zFar
+            if (glm::length2(cameraPos - chunk->chunkLocation) - (radius * radius * 4.F) <
+                (zFar * zFar))
+            {
+                if (!bIsFrustumCullingEnabled || isInFrustum(VP, chunk->chunkLocation, radius))
+                {
+                    for (const auto& visibleBlockInfos : chunk->visibleBlockInfos)
+                    {
+                        drawnBlockCount += visibleBlockInfos.size();
+                    }
+                    drawnTriangleCount += chunk->triangleCount;
+                    drawnVertexCount += chunk->vertexCount;
+                    visibleChunks.push_back(chunk);
+                }
+            }
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE0 + shadowTextureID);
+    glBindTexture(GL_TEXTURE_3D, shadowTexture);
+
+    glActiveTexture(GL_TEXTURE0 + shadowBrickTableID);
+    glBindTexture(GL_TEXTURE_3D, shadowBrickTable);
+
+    glActiveTexture(GL_TEXTURE0 + chunkLocationTextureID);
+    glBindTexture(GL_TEXTURE_BUFFER, chunkLocationTexture);
+
+    glActiveTexture(GL_TEXTURE0 + spriteTextureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, spriteTexture);
+
+    chunkShader.uniforms()
+        .setVec3("lightDir", world->getDirectLightDir())
+        .setVec3("lightColor", world->getDirectLightColor())
+        .setVec3("viewPos", world->getCamera()->getPosition())
+        .setVec3("origin", origin)
+        .setVec3("colorOverride", colorOverride)
+        .setMat4("VP", world->getCamera()->getVPMatrix())
+        .setUVec3("worldSize", getWorldSize())
+        .setVec3("chunkSize", glm::vec3(chunkSize))
+        .setUVec3("locationBitCounts", locationBitCounts)
+        .setInt("shadowTexture", shadowTextureID)
+        .setInt("shadowBrickTable", shadowBrickTableID)
+        .setInt("shadowBrickSize", shadowBrickSize)
+        .setFloat("shadowDistanceLimit", shadowDistanceLimit)
+        .setInt("spriteTexture", spriteTextureID)
+        .setFloat(
+            "time",
+            std::chrono::duration_cast<std::chrono::duration<float>>(
+                VSApp::getInstance()->getInstance()->getStartTime() -
+                std::chrono::high_resolution_clock::now())
+                .count())
+        .setBool("enableShadows", uiState->bAreShadowsEnabled)
+        .setBool("enableAO", uiState->bIsAmbientOcclusionEnabled)
+        .setBool("showAO", uiState->bShouldShowAO)
+        .setBool("showUV", uiState->bShouldShowUV)
+        .setBool("showNormals", uiState->bShouldShowNormals)
+        .setBool("showLight", uiState->bShouldShowLight);
+
+    drawCallCount = 0;
+    drawCommandCount = 0;
+
+    if (meshingMode == VSChunkMeshingMode::Greedy)
+    {
+        glBindVertexArray(meshVertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, meshArena->getBuffer());
+        setMeshAttribPointers();
+    }
+    else
+    {
+        glBindVertexArray(cubeVertexContext->vertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceArena->getBuffer());
+    }
+
+    if (bShouldCullOnGPU)
+    {
+        drawGPUCulled();
+    }
+    // multi draw indirect with base instance needs GL 4.3
+    else if (uiState->chunkDrawMode == 1 && GLAD_GL_VERSION_4_3)
+    {
+        drawMultiDrawIndirect(visibleChunks);
+    }
+    else
+    {
+        drawInstanced(visibleChunks);
+    }
+
+    glBindVertexArray(0);
+}
+
+void VSChunkManager::drawInstanced(const std::vector<VSChunk*>& visibleChunks)
+{
+    drawCommands.clear();
+    for (const auto* chunk : visibleChunks)
+    {
+        appendDrawCommands(chunk, drawCommands);
+    }
+
+    for (const auto& command : drawCommands)
+    {
+        // instance data is already on the GPU, only point the attributes at each chunk range
+        if (meshingMode == VSChunkMeshingMode::CubeInstancing)
+        {
+            setInstanceAttribPointers(
+                cubeVertexContext->lastAttribPointer + 1, command.baseInstance);
+        }
+
+        glDrawElementsInstancedBaseVertex(
+            GL_TRIANGLES,
+            command.count,
+            GL_UNSIGNED_INT,
+            (void*)(command.firstIndex * sizeof(GLuint)),
+            command.instanceCount,
+            command.baseVertex);
+
+        drawCallCount++;
+    }
+
+    drawCommandCount = drawCommands.size();
+}
+
+void VSChunkManager::drawMultiDrawIndirect(const std::vector<VSChunk*>& visibleChunks)
+{
+    drawCommands.clear();
+
+    // culled chunks are simply left out of the command list
+    for (const auto* chunk : visibleChunks)
+    {
+        appendDrawCommands(chunk, drawCommands);
+    }
+
+    if (drawCommands.empty())
+    {
+        return;
+    }
+
+    // base instance selects the chunk range, so the attributes point at the arena start
+    if (meshingMode == VSChunkMeshingMode::CubeInstancing)
+    {
+        setInstanceAttribPointers(cubeVertexContext->lastAttribPointer + 1, 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer);
+    glBufferData(
+        GL_DRAW_INDIRECT_BUFFER,
+        drawCommands.size() * sizeof(VSDrawElementsIndirectCommand),
+        drawCommands.data(),
+        GL_STREAM_DRAW);
+
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(drawCommands.size()), 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    drawCallCount++;
+    drawCommandCount = drawCommands.size();
+}
+
+void VSChunkManager::cullChunksOnGPU(
+    const glm::mat4& VP,
+    const glm::vec3& cameraPos,
+    float zFar,
+    float radius)
+{
+    if (bShouldRebuildCullEntries)
+    {
+        rebuildCullEntries();
+    }
+
+    if (cullEntryCount == 0)
+    {
+        return;
+    }
+
+    const GLuint zero = 0;
+    if (!bCanDrawIndirectCount)
+    {
+        // unused commands have to be zero so they do not draw anything
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culledDrawCommandBuffer);
+        glClearBufferData(
+            GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culledDrawCommandCountBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, chunkLocationBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, cullEntryBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, culledDrawCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, culledDrawCommandCountBuffer);
+
+    chunkCullShader->uniforms()
+        .setMat4("VP", VP)
+        .setVec3("cameraPos", cameraPos)
+        .setFloat("zFar", zFar)
+        .setFloat("radius", radius)
+        .setBool("enableFrustumCulling", bIsFrustumCullingEnabled)
+        .setInt("cullEntryCount", static_cast<GLint>(cullEntryCount));
+
+    glDispatchCompute((cullEntryCount + cullWorkGroupSize - 1) / cullWorkGroupSize, 1, 1);
+
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void VSChunkManager::rebuildCullEntries()
+{
+    std::vector<VSCullEntry> cullEntries;
+    std::vector<VSDrawElementsIndirectCommand> chunkDrawCommands;
+
+    for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
+    {
+        const auto* chunk = chunks[chunkIndex];
+
+        chunkDrawCommands.clear();
+        appendDrawCommands(chunk, chunkDrawCommands);
+        for (const auto& command : chunkDrawCommands)
+        {
+            cullEntries.push_back({command, static_cast<GLuint>(chunkIndex)});
+        }
+    }
+
+    cullEntryCount = cullEntries.size();
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cullEntryBuffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER,
+        cullEntries.size() * sizeof(VSCullEntry),
+        cullEntries.data(),
+        GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culledDrawCommandBuffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER,
+        cullEntries.size() * sizeof(VSDrawElementsIndirectCommand),
+        nullptr,
+        GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    bShouldRebuildCullEntries = false;
+}
+
+void VSChunkManager::drawGPUCulled()
+{
+    if (cullEntryCount == 0)
+    {
+        return;
+    }
+
+    if (meshingMode == VSChunkMeshingMode::CubeInstancing)
+    {
+        setInstanceAttribPointers(cubeVertexContext->lastAttribPointer + 1, 0);
+    }
+
+    // the command count is only known on the GPU
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culledDrawCommandBuffer);
+    if (bCanDrawIndirectCount)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER, culledDrawCommandCountBuffer);
+        glMultiDrawElementsIndirectCount(
+            GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, static_cast<GLsizei>(cullEntryCount), 0);
+        glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    }
+    else
+    {
+        // culled commands are zero and draw nothing
+        glMultiDrawElementsIndirect(
+            GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(cullEntryCount), 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    drawCallCount++;
+    // upper bound, the culled count stays on the GPU
+    drawCommandCount = cullEntryCount;
+}
+
+void VSChunkManager::updateChunks()
+{
+    assert(debug_isMainThread());
+
+    initializeChunks();
+
+    // Init from file asynchronous
+    if (!bShouldReinitializeChunks && bShouldInitializeFromData)
+    {
+        std::unique_lock<std::mutex> lock(worldDataMutex);
+        VSWorldData worldData = std::move(worldDataFromFile);
+        worldDataFromFile = {};
+        lock.unlock();
+
+        const auto chunkBlockCount = getChunkBlockCount();
+        // the dimensions may have changed again since the data was made
+        if (worldData.chunkSize != chunkSize || worldData.chunkCount != chunkCount ||
+            worldData.blocks.size() != chunkBlockCount * chunks.size())
+        {
+            VSLog::Log(
+                VSLog::Category::Core,
+                VSLog::Level::warn,
+                "Dropped world data of {} blocks, it does not match the world of {} blocks",
+                worldData.blocks.size(),
+                chunkBlockCount * chunks.size());
+        }
+        else
+        {
+            editEpoch++;
+
+            const auto* source = worldData.blocks.data();
+            for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
+            {
+                auto* chunk = chunks[chunkIndex];
+                auto* const blockData = getWritableBlockData(chunkIndex);
+                blockData->sections.assignBlocks(source);
+                rebuildOccupancy(blockData);
+                rebuildHeightmap(chunk);
+
+                markChunkDirty(chunkIndex);
+                source += chunkBlockCount;
+            }
+
+            rebuildLight();
+
+            editEpoch++;
+
+            publishColumnSurfaces(getAllChunkColumns());
+        }
+
+        // only cleared once the blocks are in, unless new data came in meanwhile
+        lock.lock();
+        bShouldInitializeFromData = !worldDataFromFile.blocks.empty();
+    }
+
+    // edits queued by the game systems are applied before the dirty chunks are looked at
+    if (!bShouldReinitializeChunks)
+    {
+        applyEditCommands();
+    }
+
+    activeShadowBuildTasks.removeFinishedAbandonedUpdates();
+    activeVisibilityBuildTasks.removeFinishedAbandonedUpdates();
+
+    const auto* uiState = VSApp::getInstance()->getUI()->getState();
+
+    // only chunks marked dirty since the last frame are looked at, the rebuild queues decide
+    // which of them are rebuilt first
+    std::size_t dirtyChunkIndex = 0;
+    while (dirtyChunkIndices.try_dequeue(dirtyChunkIndex))
+    {
+        auto* const chunk = chunks[dirtyChunkIndex];
+        {
+            // edits after this point queue the chunk again
+            const std::lock_guard lock(chunk->dirtyRegionMutex);
+            chunk->bIsDirty = false;
+            chunk->rebuildRegion.add(chunk->dirtyRegion);
+            chunk->dirtyRegion = {};
+        }
+        visibilityRebuildQueue.push(dirtyChunkIndex);
+    }
+    // shadows stay queued while disabled, so enabling them rebuilds everything missed
+    while (uiState->bAreShadowsEnabled && shadowDirtyChunkIndices.try_dequeue(dirtyChunkIndex))
+    {
+        chunks[dirtyChunkIndex]->bShouldRebuildShadows = false;
+        shadowRebuildQueue.push(dirtyChunkIndex);
+    }
+
+    // priorities depend on the camera, so they are recomputed every frame
+    const auto getRebuildPriority = [this](std::size_t chunkIndex, float waitSeconds) {
+        const auto chunkLocation = chunks[chunkIndex]->chunkLocation;
+        const auto radius = glm::length(glm::vec3(chunkSize));
+        auto priority = glm::length(frozenCameraPos - chunkLocation);
+        if (!isInFrustum(frozenVPMatrix, chunkLocation, radius))
+        {
+            priority += rebuildOutsideFrustumPenalty;
+        }
+        // chunks that waited long enough overtake closer ones
+        return priority - waitSeconds * rebuildPriorityPerSecond;
+    };
+
+    visibilityRebuildQueue.prioritize(getRebuildPriority);
+    std::size_t rebuildChunkIndex = 0;
+    while (activeVisibilityBuildTasks.size() < maxShadowUpdateThreads &&
+           visibilityRebuildQueue.pop(rebuildChunkIndex))
+    {
+        startVisibilityUpdate(rebuildChunkIndex);
+    }
+
+    // copied, finished updates are removed while iterating
+    for (const auto chunkIndex : std::vector(activeVisibilityBuildTasks.getChunkIndices()))
+    {
+        updateVisibleBlocks(chunkIndex);
+    }
+
+    if (uiState->bAreShadowsEnabled)
+    {
+        const bool bShouldBuildShadowsOnGPU = uiState->shadowBuildMode == 1 &&
+                                              shadowJumpFloodShader &&
+                                              doesShadowRegionFitJumpFlood(chunkSize);
+
+        shadowRebuildQueue.prioritize(getRebuildPriority);
+        if (bShouldBuildShadowsOnGPU)
+        {
+            std::size_t gpuShadowUpdateCount = 0;
+            while (gpuShadowUpdateCount < maxGPUShadowUpdatesPerFrame &&
+                   shadowRebuildQueue.pop(rebuildChunkIndex))
+            {
+                updateShadowsOnGPU(rebuildChunkIndex);
+                gpuShadowUpdateCount++;
+            }
+        }
+        else
+        {
+            while (activeShadowBuildTasks.size() < maxShadowUpdateThreads &&
+                   shadowRebuildQueue.pop(rebuildChunkIndex))
+            {
+                startShadowUpdate(rebuildChunkIndex);
+            }
+
+            for (const auto chunkIndex : std::vector(activeShadowBuildTasks.getChunkIndices()))
+            {
+                updateShadows(chunkIndex);
+            }
+        }
+    }
+
+    uploadedInstanceBytes = getChunkArena()->consumeUploadedBytes();
+}
+
+glm::vec3 VSChunkManager::getOrigin() const
+{
+    return origin;
+}
+
+void VSChunkManager::setOrigin(const glm::vec3& newOrigin)
+{
+    origin = newOrigin;
+}
+
+bool VSChunkManager::isFrustumCullingEnabled() const
+{
+    return bIsFrustumCullingEnabled;
+}
+
+void VSChunkManager::setIsFrustumCullingEnabled(bool state)
+{
+    bIsFrustumCullingEnabled = state;
+}
+
+glm::vec3 VSChunkManager::getColorOverride() const
+{
+    return colorOverride;
+}
+
+void VSChunkManager::setColorOverride(const glm::vec3& newColorOverride)
+{
+    colorOverride = newColorOverride;
+}
+
+void VSChunkManager::setChunkDimensions(
+    const glm::ivec3& inChunkSize,
+    const glm::ivec3& inChunkCount)
+{
+    // Force even number of chunks along x and z and even number of blocks, layers of chunks
+    // along y can be stacked freely
+    const auto chunkSizeToSet = (inChunkSize / 2) * 2;
+    const auto chunkCountToSet =
+        glm::ivec3((inChunkCount.x / 2) * 2, inChunkCount.y, (inChunkCount.z / 2) * 2);
+
+    // packed instances hold the block location in the chunk and the chunk index in 32 bits
+    const auto packedBitCount = getBitCount(chunkSizeToSet.x) + getBitCount(chunkSizeToSet.y) +
+                                getBitCount(chunkSizeToSet.z) +
+                                getBitCount(glm::compMul(chunkCountToSet));
+    if (packedBitCount > 32)
+    {
+        VSLog::Log(
+            VSLog::Category::Core,
+            VSLog::Level::err,
+            "Chunk size {} and chunk count {} do not fit into a packed instance, the world is kept",
+            glm::to_string(chunkSizeToSet),
+            glm::to_string(chunkCountToSet));
+        return;
+    }
+
+    if (shadowJumpFloodShader && !doesShadowRegionFitJumpFlood(chunkSizeToSet))
+    {
+        VSLog::Log(
+            VSLog::Category::Core,
+            VSLog::Level::warn,
+            "Chunk size {} does not fit into the GPU shadow seeds, shadows are built on the CPU",
+            glm::to_string(chunkSizeToSet));
+    }
+
+    std::lock_guard<std::mutex> lock(worldDataMutex);
+    newChunkSize = chunkSizeToSet;
+    newChunkCount = chunkCountToSet;
+    newWorldSize = newChunkSize * newChunkCount;
+    newWorldSizeHalf = newWorldSize / 2;
+    bShouldReinitializeChunks = true;
+}
+
+bool VSChunkManager::doesShadowRegionFitJumpFlood(const glm::ivec3& chunkSizeToCheck)
+{
+    // shadow regions span up to three chunks along each axis
+    return glm::all(glm::lessThanEqual(chunkSizeToCheck * 3, maxJumpFloodRegionSize));
+}
+
+std::size_t VSChunkManager::getChunkBlockCount() const
+{
+    return glm::compMul(chunkSize);
+}
+
+std::size_t VSChunkManager::getTotalBlockCount() const
+{
+    return glm::compMul(chunkSize) * getTotalChunkCount();
+}
+
+std::size_t VSChunkManager::getVisibleBlockCount() const
+{
+    return std::accumulate(chunks.begin(), chunks.end(), 0, [](std::size_t acc, VSChunk* curr) {
+        return acc +
                std::accumulate(
                    curr->visibleBlockInfos.begin(),
                    curr->visibleBlockInfos.end(),
@@ -489,558 +1361,2234 @@ std::size_t VSChunkManager::getVisibleBlockCount() const
     });
 }
 
-std::size_t VSChunkManager::getDrawnBlockCount() const
+std::size_t VSChunkManager::getDrawnBlockCount() const
+{
+    return drawnBlockCount;
+}
+
+std::size_t VSChunkManager::getDrawnTriangleCount() const
+{
+    return drawnTriangleCount;
+}
+
+std::size_t VSChunkManager::getDrawnVertexCount() const
+{
+    return drawnVertexCount;
+}
+
+std::size_t VSChunkManager::getTotalChunkCount() const
+{
+    return glm::compMul(chunkCount);
+}
+
+std::size_t VSChunkManager::getDrawCallCount() const
+{
+    return drawCallCount;
+}
+
+std::size_t VSChunkManager::getDrawCommandCount() const
+{
+    return drawCommandCount;
+}
+
+std::size_t VSChunkManager::getUploadedInstanceBytes() const
+{
+    return uploadedInstanceBytes;
+}
+
+std::size_t VSChunkManager::getChunkMemoryBytes() const
+{
+    return chunkMemory.getReservedBytes();
+}
+
+std::size_t VSChunkManager::getVisibilityRebuildQueueSize() const
+{
+    return visibilityRebuildQueue.size();
+}
+
+float VSChunkManager::getVisibilityRebuildWaitSeconds() const
+{
+    return visibilityRebuildQueue.getAverageWaitSeconds();
+}
+
+std::size_t VSChunkManager::getShadowRebuildQueueSize() const
+{
+    return shadowRebuildQueue.size();
+}
+
+float VSChunkManager::getShadowRebuildWaitSeconds() const
+{
+    return shadowRebuildQueue.getAverageWaitSeconds();
+}
+
+std::size_t VSChunkManager::getShadowPageCount() const
+{
+    return nextShadowPage - freeShadowPages.size();
+}
+
+bool VSChunkManager::shouldReinitializeChunks() const
+{
+    return bShouldReinitializeChunks.load();
+}
+
+bool VSChunkManager::isLocationInBounds(const glm::vec3& location) const
+{
+    return (
+        (location.x >= -worldSizeHalf.x && location.x < worldSizeHalf.x) &&
+        (location.y >= -worldSizeHalf.y && location.y < worldSizeHalf.y) &&
+        (location.z >= -worldSizeHalf.z && location.z < worldSizeHalf.z));
+}
+
+VSChunkManager::VSTraceResult
+VSChunkManager::lineTrace(const glm::vec3& start, const glm::vec3& end) const
+{
+    const glm::vec3 startToEnd = end - start;
+
+    const float maxRayLength = glm::length(startToEnd);
+
+    const auto rayDir = startToEnd / maxRayLength;
+
+    float t = 0.F;
+
+    while (!bShouldReinitializeChunks && t < maxRayLength)
+    {
+        const auto samplePos = start + rayDir * t;
+        if (!bShouldReinitializeChunks && isLocationInBounds(samplePos))
+        {
+            const auto blockSample = getBlock(samplePos);
+            if (blockSample != VS_DEFAULT_BLOCK_ID)
+            {
+                const auto centerToHitPos = glm::fract(samplePos) - 0.5F;
+
+                glm::vec3 d = glm::abs(centerToHitPos) - 0.5F;
+                const auto distToSurface = length(glm::max(d, glm::vec3(0.F))) +
+                                           glm::min(glm::max(glm::max(d.x, d.y), d.z), 0.F);
+
+                auto interSectionPos = samplePos - rayDir * distToSurface;
+
+                // calc normals
+
+                auto normal = glm::vec3(0, 0, 0);
+
+                if (d.x > d.y && d.x > d.z)
+                {
+                    normal = {glm::sign(centerToHitPos.x) * 1.F, 0.F, 0.F};
+                    interSectionPos.x = glm::round(interSectionPos.x);
+                    if (centerToHitPos.x < 0)
+                    {
+                        interSectionPos.x -= 0.00001F;
+                    }
+                }
+
+                if (d.y > d.x && d.y > d.z)
+                {
+                    normal = {0.F, glm::sign(centerToHitPos.y) * 1.F, 0.F};
+                    interSectionPos.y = glm::round(interSectionPos.y);
+                    if (centerToHitPos.y < 0)
+                    {
+                        interSectionPos.y -= 0.00001F;
+                    }
+                }
+
+                if (d.z > d.x && d.z > d.y)
+                {
+                    normal = {0.F, 0.F, glm::sign(centerToHitPos.z) * 1.F};
+                    interSectionPos.z = glm::round(interSectionPos.z);
+                    if (centerToHitPos.z < 0)
+                    {
+                        interSectionPos.z -= 0.00001F;
+                    }
+                }
+
+                return VSChunkManager::VSTraceResult{true, interSectionPos, normal, blockSample};
+            }
+        }
+        t += 0.0075F;
+    }
+
+    return {false, {}, {}, VS_DEFAULT_BLOCK_ID};
+}
+
+VSChunkManager::VSTraceResult VSChunkManager::getSurface(const glm::vec3& location) const
+{
+    // The main thread replaces the surfaces after every edit while they are read. Only the
+    // dimensions stored with them are used, the world may be set up again meanwhile.
+    const auto columnSurfacesSnapshot = std::atomic_load(&columnSurfaces);
+    if (!columnSurfacesSnapshot)
+    {
+        return {};
+    }
+    const auto& [snapshotChunkSize, snapshotChunkCount, snapshotWorldSizeHalf, columns] =
+        *columnSurfacesSnapshot;
+
+    const auto zeroBaseLocation = glm::ivec3(glm::floor(location)) + snapshotWorldSizeHalf;
+    const auto snapshotWorldSize = snapshotChunkSize * snapshotChunkCount;
+    if (zeroBaseLocation.x < 0 || zeroBaseLocation.x >= snapshotWorldSize.x ||
+        zeroBaseLocation.z < 0 || zeroBaseLocation.z >= snapshotWorldSize.z)
+    {
+        return {};
+    }
+
+    const auto chunkColumn = glm::ivec2(
+        zeroBaseLocation.x / snapshotChunkSize.x, zeroBaseLocation.z / snapshotChunkSize.z);
+    const auto& surfaces = columns[chunkColumn.x + chunkColumn.y * snapshotChunkCount.x];
+    if (!surfaces)
+    {
+        return {};
+    }
+    const auto& surface =
+        (*surfaces)[zeroBaseLocation.x - chunkColumn.x * snapshotChunkSize.x +
+                    (zeroBaseLocation.z - chunkColumn.y * snapshotChunkSize.z) *
+                        snapshotChunkSize.x];
+    if (surface.height < 0)
+    {
+        return {};
+    }
+
+    const auto surfaceLocation =
+        glm::vec3(location.x, surface.height - snapshotWorldSizeHalf.y, location.z);
+    return {
+        true,
+        surfaceLocation + glm::vec3(0.F, 1.F, 0.F),
+        glm::vec3(0.F, 1.F, 0.F),
+        surface.blockID};
+}
+
+VSChunkManager::VSWorldData VSChunkManager::getData() const
+{
+    VSChunkManager::VSWorldData worldData{};
+
+    worldData.chunkSize = chunkSize;
+    worldData.chunkCount = getChunkCount();
+
+    // Write BlockIDs to vector
+    worldData.blocks = std::vector<VSBlockID>();
+
+    for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
+    {
+        const auto blockData = freezeBlockData(chunkIndex);
+        const auto offset = worldData.blocks.size();
+        worldData.blocks.resize(offset + getChunkBlockCount());
+        for (std::size_t rowStart = 0; rowStart < getChunkBlockCount(); rowStart += chunkSize.x)
+        {
+            blockData->sections.copyRowBlocks(
+                rowStart, chunkSize.x, worldData.blocks.data() + offset + rowStart);
+        }
+    }
+
+    return worldData;
+}
+
+void VSChunkManager::initFromData(VSWorldData data)
+{
+    setChunkDimensions(data.chunkSize, data.chunkCount);
+    setWorldData(std::move(data));
+}
+
+void VSChunkManager::initializeChunks()
+{
+    if (bShouldReinitializeChunks)
+    {
+        // Running updates read the chunks and the dimensions, so they have to stop before either
+        // changes. Visibility updates build their snapshot on the worker.
+        activeShadowBuildTasks.cancelAndWait();
+        activeVisibilityBuildTasks.cancelAndWait();
+
+        {
+            std::lock_guard<std::mutex> lock(worldDataMutex);
+            chunkSize = newChunkSize;
+            chunkCount = newChunkCount;
+            worldSize = newWorldSize;
+            worldSizeHalf = newWorldSizeHalf;
+        }
+
+        visibilityRebuildQueue.clear();
+        shadowRebuildQueue.clear();
+        std::size_t staleChunkIndex = 0;
+        while (dirtyChunkIndices.try_dequeue(staleChunkIndex) ||
+               shadowDirtyChunkIndices.try_dequeue(staleChunkIndex))
+        {
+        }
+        // queued edits target the old world
+        VSEditCommand staleEditCommand;
+        while (editCommands.try_dequeue(staleEditCommand))
+        {
+        }
+
+        // chunks of the old world are emptied and reused, the arena drops all of their ranges
+        getChunkArena()->reset();
+        bShouldRebuildCullEntries = true;
+        chunkPool.resize(glm::compMul(chunkCount));
+        chunks.resize(chunkPool.size());
+        activeShadowBuildTasks.resize(chunks.size());
+        activeVisibilityBuildTasks.resize(chunks.size());
+
+        locationBitCounts = {
+            getBitCount(chunkSize.x), getBitCount(chunkSize.y), getBitCount(chunkSize.z)};
+        // setChunkDimensions refuses dimensions that do not fit
+        assert(glm::compAdd(locationBitCounts) + getBitCount(chunks.size()) <= 32);
+
+        for (std::size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++)
+        {
+            auto* const chunk = chunkPool.get(chunkIndex);
+            resetChunk(chunk);
+            // center of the chunk, the world is centered around the origin
+            chunk->chunkLocation =
+                glm::vec3(chunkSize) *
+                    (glm::vec3(chunkIndexToChunkCoordinates(chunkIndex)) + 0.5F) -
+                glm::vec3(worldSize) / 2.F;
+            chunks[chunkIndex] = chunk;
+        }
+
+        uploadChunkLocations();
+
+        publishColumnSurfaces(getAllChunkColumns());
+
+        shadowBrickCount = (worldSize + shadowBrickSize - 1) / shadowBrickSize;
+
+        // start with about one page per brick column, most columns only cross the surface once
+        const auto shadowPoolPagesPerLayer = shadowPoolPagesPerAxis * shadowPoolPagesPerAxis;
+        createShadowBrickPool(glm::max(
+            1,
+            (shadowBrickCount.x * shadowBrickCount.z + shadowPoolPagesPerLayer - 1) /
+                shadowPoolPagesPerLayer));
+
+        if (shadowJumpFloodShader)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadowSeedBuffer);
+            glBufferData(
+                GL_SHADER_STORAGE_BUFFER,
+                chunks.size() * getShadowSeedWordsPerChunk() * sizeof(std::uint32_t),
+                nullptr,
+                GL_DYNAMIC_DRAW);
+            const GLuint zero = 0;
+            glClearBufferData(
+                GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+            // the largest region is a chunk with all of its neighbours
+            const auto maxRegionSize = glm::min(chunkCount, 3) * chunkSize;
+            for (const auto jumpFloodBuffer : jumpFloodBuffers)
+            {
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, jumpFloodBuffer);
+                glBufferData(
+                    GL_SHADER_STORAGE_BUFFER,
+                    glm::compMul(maxRegionSize) * sizeof(GLuint),
+                    nullptr,
+                    GL_DYNAMIC_DRAW);
+            }
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+
+        // dimensions set again in the meantime are picked up on the next call
+        std::lock_guard<std::mutex> lock(worldDataMutex);
+        bShouldReinitializeChunks = newChunkSize != chunkSize || newChunkCount != chunkCount;
+    }
+}
+
+void VSChunkManager::uploadChunkLocations()
+{
+    std::vector<glm::vec4> chunkLocations;
+    chunkLocations.reserve(chunks.size());
+    for (const auto* chunk : chunks)
+    {
+        chunkLocations.emplace_back(chunk->chunkLocation, 1.F);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, chunkLocationBuffer);
+    glBufferData(
+        GL_TEXTURE_BUFFER,
+        chunkLocations.size() * sizeof(glm::vec4),
+        chunkLocations.data(),
+        GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, chunkLocationTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, chunkLocationBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+bool VSChunkManager::isInFrustum(const glm::mat4& VP, const glm::vec3& location, float radius)
+{
+    // bounding sphere in projection space
+    const auto locationInP = VP * glm::vec4(location, 1.F);
+    return (glm::abs(locationInP.x) - radius) < locationInP.w &&
+           (glm::abs(locationInP.y) - radius) < locationInP.w;
+}
+
+void VSChunkManager::resetChunk(VSChunk* chunk) const
+{
+    // block data is only reused if no reader holds a frozen version of it anymore
+    if (!chunk->blockData || chunk->blockData.use_count() > 1)
+    {
+        chunk->blockData = createBlockData();
+    }
+    auto& blockData = *chunk->blockData;
+    // All blocks start as air open to the sky, no block light and full sky light. Sections of
+    // reused block data keep their buffers.
+    blockData.sections.reset(chunkSize, static_cast<std::uint8_t>(maxLight << (SkyLight * 4)));
+    blockData.occupancy.assign(chunkSize.x <= 64 ? chunkSize.y * chunkSize.z : 0, 0);
+    blockData.bIsFrozen = false;
+
+    // snapshots are only taken on the main thread, so a single owner stays the only one
+    if (!chunk->bIsBlockVisible || chunk->bIsBlockVisible.use_count() > 1)
+    {
+        chunk->bIsBlockVisible = createBlockVisibility();
+    }
+    chunk->bIsBlockVisible->assign(getChunkBlockCount(), false);
+    chunk->heightmap.assign(chunkSize.x * chunkSize.z, -1);
+
+    chunk->bIsDirty = false;
+    chunk->bShouldRebuildShadows = false;
+    chunk->generation = 0;
+    chunk->shadowGeneration = 0;
+    chunk->dirtyRegion = {};
+    chunk->rebuildRegion = {};
+    chunk->updateRegion = {};
+
+    // the vectors keep their capacity for the blocks of the new world
+    for (auto& visibleBlockInfos : chunk->visibleBlockInfos)
+    {
+        visibleBlockInfos.clear();
+    }
+    chunk->instanceAllocation = {};
+    chunk->instanceOffsets = {};
+    chunk->instanceCapacities = {};
+    chunk->meshAllocation = {};
+    chunk->meshQuadCount = 0;
+    chunk->triangleCount = 0;
+    chunk->vertexCount = 0;
+}
+
+void VSChunkManager::markChunkDirty(std::size_t chunkIndex)
+{
+    markChunkDirty(chunkIndex, getChunkRegion());
+}
+
+void VSChunkManager::markChunkDirty(std::size_t chunkIndex, const VSChunk::VSBlockRegion& region)
+{
+    auto* const chunk = chunks[chunkIndex];
+    bool bWasDirty = false;
+    {
+        const std::lock_guard lock(chunk->dirtyRegionMutex);
+        chunk->dirtyRegion.add(region);
+        chunk->generation++;
+        bWasDirty = chunk->bIsDirty.exchange(true);
+    }
+    // only the first change since the chunk was picked up queues it
+    if (!bWasDirty)
+    {
+        dirtyChunkIndices.enqueue(chunkIndex);
+    }
+}
+
+void VSChunkManager::markRegionNeighbourhoodDirty(
+    const glm::ivec3& chunkCoordinates,
+    const VSChunk::VSBlockRegion& region)
+{
+    // visibility and corner light of a block depend on the blocks next to it, the neighbourhood
+    // only reaches into the chunks next to a chunk border
+    for (int z = -1; z <= 1; z++)
+    {
+        for (int y = -1; y <= 1; y++)
+        {
+            for (int x = -1; x <= 1; x++)
+            {
+                const auto offset = glm::ivec3(x, y, z);
+                const auto neighbourCoordinates = chunkCoordinates + offset;
+                if (glm::any(glm::lessThan(neighbourCoordinates, glm::ivec3(0))) ||
+                    glm::any(glm::greaterThanEqual(neighbourCoordinates, chunkCount)))
+                {
+                    continue;
+                }
+
+                const auto neighbourOffset = offset * chunkSize;
+                VSChunk::VSBlockRegion neighbourRegion;
+                neighbourRegion.min = glm::max(region.min - neighbourOffset - 1, glm::ivec3(0));
+                neighbourRegion.max = glm::min(region.max - neighbourOffset + 1, chunkSize - 1);
+                if (!neighbourRegion.isEmpty())
+                {
+                    markChunkDirty(
+                        chunkCoordinatesToChunkIndex(neighbourCoordinates), neighbourRegion);
+                }
+            }
+        }
+    }
+}
+
+VSChunkManager::VSChunk::VSBlockRegion VSChunkManager::getChunkRegion() const
+{
+    VSChunk::VSBlockRegion region;
+    region.min = glm::ivec3(0);
+    region.max = chunkSize - 1;
+    return region;
+}
+
+void VSChunkManager::markChunkShadowsDirty(std::size_t chunkIndex)
+{
+    auto* const chunk = chunks[chunkIndex];
+    chunk->shadowGeneration++;
+    if (!chunk->bShouldRebuildShadows.exchange(true))
+    {
+        shadowDirtyChunkIndices.enqueue(chunkIndex);
+    }
+}
+
+void VSChunkManager::startShadowUpdate(std::size_t chunkIndex)
+{
+    auto* const chunk = chunks[chunkIndex];
+
+    VSShadowSources sources;
+    const auto [regionMin, regionMax] = getShadowRegion(chunkIndex);
+    for (int z = regionMin.z; z <= regionMax.z; z++)
+    {
+        for (int y = regionMin.y; y <= regionMax.y; y++)
+        {
+            for (int x = regionMin.x; x <= regionMax.x; x++)
+            {
+                const auto regionChunkIndex = chunkCoordinatesToChunkIndex({x, y, z});
+                sources.blockData.push_back(freezeBlockData(regionChunkIndex));
+                sources.bIsBlockVisible.push_back(chunks[regionChunkIndex]->bIsBlockVisible);
+            }
+        }
+    }
+
+    const auto shadowUpdate = VSShadwoChunkUpdate::create(
+        [this, sources = std::move(sources)](
+            const std::atomic<bool>& bShouldCancel,
+            std::atomic<bool>& bIsReady,
+            std::size_t chunkIndex) {
+            return this->chunkUpdateShadow(bShouldCancel, bIsReady, chunkIndex, sources);
+        },
+        chunkIndex,
+        chunk->shadowGeneration);
+
+    activeShadowBuildTasks.add(chunkIndex, shadowUpdate);
+}
+
+void VSChunkManager::updateShadows(std::size_t chunkIndex)
+{
+    auto* const chunk = chunks[chunkIndex];
+    if (activeShadowBuildTasks.get(chunkIndex))
+    {
+        const auto shadowTask = activeShadowBuildTasks.get(chunkIndex);
+        if (shadowTask->isReady())
+        {
+            const auto shadowBricks = shadowTask->getResult();
+            activeShadowBuildTasks.remove(chunkIndex);
+
+            // the chunk changed while building, the pending rebuild replaces this result
+            if (shadowTask->getGeneration() == chunk->shadowGeneration)
+            {
+                uploadShadowBricks(shadowBricks);
+            }
+        }
+    }
+}
+
+VSChunkManager::VSShadowBricks VSChunkManager::chunkUpdateShadow(
+    const std::atomic<bool>& bShouldCancel,
+    std::atomic<bool>& bIsReady,
+    std::size_t chunkIndex,
+    const VSShadowSources& sources) const
+{
+    // the neighbouring chunks form the apron around this chunk
+    const auto [regionMin, regionMax] = getShadowRegion(chunkIndex);
+    const auto regionChunkCount = regionMax - regionMin + 1;
+    const auto getSourceIndex = [&regionMin = regionMin, &regionChunkCount](
+                                    const glm::ivec3& chunkCoordinates) {
+        const auto regionChunkCoordinates = chunkCoordinates - regionMin;
+        return static_cast<std::size_t>(
+            regionChunkCoordinates.x + regionChunkCoordinates.y * regionChunkCount.x +
+            regionChunkCoordinates.z * regionChunkCount.x * regionChunkCount.y);
+    };
+    const auto regionSize = regionChunkCount * chunkSize;
+    const auto regionOrigin = regionMin * chunkSize;
+
+    const auto getRegionIndex = [&regionSize](const glm::ivec3& regionCoordinates) {
+        return regionCoordinates.x + regionCoordinates.y * regionSize.x +
+               static_cast<std::size_t>(regionCoordinates.z) * regionSize.x * regionSize.y;
+    };
+
+    // visible blocks are the features of the distance transform
+    std::vector<float> squaredDistances(glm::compMul(regionSize), VSDistanceTransform::infinity);
+
+    for (int z = regionMin.z; z <= regionMax.z; z++)
+    {
+        for (int y = regionMin.y; y <= regionMax.y; y++)
+        {
+            for (int x = regionMin.x; x <= regionMax.x; x++)
+            {
+                // abort calculations if canceled
+                if (bShouldCancel)
+                {
+                    return {};
+                }
+                const auto regionChunkCoordinates = glm::ivec3(x, y, z);
+                const auto sourceIndex = getSourceIndex(regionChunkCoordinates);
+                const auto& bIsBlockVisible = *sources.bIsBlockVisible[sourceIndex];
+                const auto& sections = sources.blockData[sourceIndex]->sections;
+                const auto chunkOffset = (regionChunkCoordinates - regionMin) * chunkSize;
+                for (int blockY = 0; blockY < chunkSize.y; blockY++)
+                {
+                    // air sections have no visible blocks
+                    const auto sectionIndex = VSChunkSections::getSectionIndex(blockY);
+                    if (sections.isSectionUniform(sectionIndex) &&
+                        sections.getSectionBlock(sectionIndex) == VS_DEFAULT_BLOCK_ID)
+                    {
+                        continue;
+                    }
+
+                    for (int blockZ = 0; blockZ < chunkSize.z; blockZ++)
+                    {
+                        for (int blockX = 0; blockX < chunkSize.x; blockX++)
+                        {
+                            const auto blockCoordinates = glm::ivec3(blockX, blockY, blockZ);
+                            if (bIsBlockVisible[blockCoordinatesToBlockIndex(blockCoordinates)])
+                            {
+                                squaredDistances[getRegionIndex(
+                                    chunkOffset + blockCoordinates)] = 0.F;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (bShouldCancel)
+    {
+        return {};
+    }
+
+    VSDistanceTransform().compute(squaredDistances, regionSize);
+
+    // 0 for visible blocks, -0.5 inside and the distance to the closest visible block in air,
+    // capped at shadowDistanceLimit
+    const auto getDistance = [&](const glm::ivec3& texel) {
+        const auto regionCoordinates = texel - regionOrigin;
+        if (glm::any(glm::lessThan(regionCoordinates, glm::ivec3(0))) ||
+            glm::any(glm::greaterThanEqual(regionCoordinates, regionSize)))
+        {
+            return shadowDistanceLimit;
+        }
+
+        const auto [texelChunkCoordinates, blockIndex] =
+            worldCoordinatesToChunkCoordinatesAndBlockIndex(texel);
+        const auto sourceIndex = getSourceIndex(texelChunkCoordinates);
+        if (sources.blockData[sourceIndex]->sections.getBlock(blockIndex) != VS_DEFAULT_BLOCK_ID)
+        {
+            return (*sources.bIsBlockVisible[sourceIndex])[blockIndex] ? 0.F : -0.5F;
+        }
+
+        const auto squaredDistance = squaredDistances[getRegionIndex(regionCoordinates)];
+        if (squaredDistance >= VSDistanceTransform::infinity)
+        {
+            return shadowDistanceLimit;
+        }
+        return glm::min(glm::sqrt(squaredDistance), shadowDistanceLimit);
+    };
+
+    const auto chunkOrigin = chunkIndexToChunkCoordinates(chunkIndex) * chunkSize;
+
+    VSShadowBricks result;
+    auto& layout = result.layout;
+    layout.firstBrick = chunkOrigin / shadowBrickSize;
+    layout.brickCount = (chunkOrigin + chunkSize - 1) / shadowBrickSize - layout.firstBrick + 1;
+
+    std::vector<float> pageDistances(shadowPageSize * shadowPageSize * shadowPageSize);
+
+    for (int brickZ = 0; brickZ < layout.brickCount.z; brickZ++)
+    {
+        if (bShouldCancel)
+        {
+            return {};
+        }
+
+        for (int brickY = 0; brickY < layout.brickCount.y; brickY++)
+        {
+            for (int brickX = 0; brickX < layout.brickCount.x; brickX++)
+            {
+                const auto brickOrigin =
+                    (layout.firstBrick + glm::ivec3(brickX, brickY, brickZ)) * shadowBrickSize;
+
+                float minDistance = std::numeric_limits<float>::max();
+                bool bHasVisibleBlock = false;
+
+                auto pageDistance = pageDistances.begin();
+                for (int z = 0; z < shadowPageSize; z++)
+                {
+                    for (int y = 0; y < shadowPageSize; y++)
+                    {
+                        for (int x = 0; x < shadowPageSize; x++)
+                        {
+                            const auto distance = getDistance(brickOrigin + glm::ivec3(x, y, z));
+                            *pageDistance++ = distance;
+
+                            // the last texel on each axis belongs to the next brick
+                            if (x < shadowBrickSize && y < shadowBrickSize && z < shadowBrickSize)
+                            {
+                                minDistance = glm::min(minDistance, distance);
+                                bHasVisibleBlock |= distance == 0.F;
+                            }
+                        }
+                    }
+                }
+
+                const auto centerTexel = brickOrigin + glm::ivec3(shadowBrickSize / 2);
+                const auto centerDistance =
+                    glm::all(glm::lessThan(centerTexel, worldSize)) ? getDistance(centerTexel)
+                                                                    : minDistance;
+
+                // only bricks with surface need the full resolution
+                layout.bNeedsPage.push_back(bHasVisibleBlock);
+                result.minDistances.push_back(minDistance);
+                result.centerDistances.push_back(centerDistance);
+                if (bHasVisibleBlock)
+                {
+                    result.pageDistances.insert(
+                        result.pageDistances.end(), pageDistances.begin(), pageDistances.end());
+                }
+            }
+        }
+    }
+
+    bIsReady = true;
+
+    return result;
+}
+
+std::tuple<glm::ivec3, glm::ivec3> VSChunkManager::getShadowRegion(std::size_t chunkIndex) const
+{
+    const auto chunkCoords = chunkIndexToChunkCoordinates(chunkIndex);
+
+    // TODO this wont work anymore if the terrain becomes more complex
+    // overhangs or floating stuff will cause issues
+    const std::int32_t chunkRadius =
+        1;  // glm::min(1, 128 / static_cast<int>(glm::sqrt(chunkSize.x * chunkSize.x +
+    // chunkSize.z * chunkSize.z)));
+
+    return {
+        glm::max(chunkCoords - chunkRadius, glm::ivec3(0)),
+        glm::min(chunkCoords + chunkRadius, chunkCount - 1)};
+}
+
+VSChunkManager::VSShadowBrickLayout VSChunkManager::getShadowBrickLayout(std::size_t chunkIndex) const
+{
+    const auto chunkOrigin = chunkIndexToChunkCoordinates(chunkIndex) * chunkSize;
+
+    VSShadowBrickLayout layout;
+    layout.firstBrick = chunkOrigin / shadowBrickSize;
+    layout.brickCount = (chunkOrigin + chunkSize - 1) / shadowBrickSize - layout.firstBrick + 1;
+    layout.bNeedsPage.resize(glm::compMul(layout.brickCount), false);
+
+    // bricks at the chunk border can contain blocks of the neighbouring chunks
+    const auto [regionMin, regionMax] = getShadowRegion(chunkIndex);
+    for (int z = regionMin.z; z <= regionMax.z; z++)
+    {
+        for (int y = regionMin.y; y <= regionMax.y; y++)
+        {
+            for (int x = regionMin.x; x <= regionMax.x; x++)
+            {
+                const auto neighbourCoordinates = glm::ivec3(x, y, z);
+                const auto* neighbourChunk =
+                    chunks[chunkCoordinatesToChunkIndex(neighbourCoordinates)];
+                const auto neighbourOrigin = neighbourCoordinates * chunkSize;
+                for (const auto& visibleBlockInfos : neighbourChunk->visibleBlockInfos)
+                {
+                    for (const auto& blockInfo : visibleBlockInfos)
+                    {
+                        const auto brick =
+                            (neighbourOrigin + unpackBlockCoordinates(blockInfo.packedLocation)) /
+                                shadowBrickSize -
+                            layout.firstBrick;
+                        if (glm::all(glm::greaterThanEqual(brick, glm::ivec3(0))) &&
+                            glm::all(glm::lessThan(brick, layout.brickCount)))
+                        {
+                            layout.bNeedsPage
+                                [brick.x + brick.y * layout.brickCount.x +
+                                 brick.z * layout.brickCount.x * layout.brickCount.y] = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return layout;
+}
+
+void VSChunkManager::createShadowBrickPool(int pageCountZ)
+{
+    shadowPoolPageCountZ = glm::min(pageCountZ, getMaxShadowPageCountZ());
+
+    glDeleteTextures(1, &shadowTexture);
+    shadowTexture = createShadowPoolTexture(shadowPoolPageCountZ);
+
+    // all bricks start without a page and without any surface in range
+    const std::vector<glm::vec4> emptyBricks(
+        glm::compMul(shadowBrickCount),
+        glm::vec4(-1.F, shadowDistanceLimit, 0.F, shadowDistanceLimit));
+
+    glDeleteTextures(1, &shadowBrickTable);
+
+    glGenTextures(1, &shadowBrickTable);
+    glBindTexture(GL_TEXTURE_3D, shadowBrickTable);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage3D(
+        GL_TEXTURE_3D,
+        0,
+        GL_RGBA16F,
+        shadowBrickCount.x,
+        shadowBrickCount.y,
+        shadowBrickCount.z,
+        0,
+        GL_RGBA,
+        GL_FLOAT,
+        emptyBricks.data());
+
+    shadowBrickPages.assign(glm::compMul(shadowBrickCount), -1);
+    freeShadowPages.clear();
+    nextShadowPage = 0;
+}
+
+int VSChunkManager::getMaxShadowPageCountZ() const
+{
+    int maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+    return maxTextureSize / shadowPageSize;
+}
+
+GLuint VSChunkManager::createShadowPoolTexture(int pageCountZ) const
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(
+        GL_TEXTURE_3D,
+        0,
+        GL_R16F,
+        shadowPoolPagesPerAxis * shadowPageSize,
+        shadowPoolPagesPerAxis * shadowPageSize,
+        pageCountZ * shadowPageSize,
+        0,
+        GL_RED,
+        GL_FLOAT,
+        nullptr);
+    return texture;
+}
+
+void VSChunkManager::growShadowBrickPool(int pageCountZ)
+{
+    pageCountZ = glm::min(pageCountZ, getMaxShadowPageCountZ());
+    if (pageCountZ <= shadowPoolPageCountZ)
+    {
+        return;
+    }
+
+    // pages are numbered layer by layer along z, so the old pool is the front of the new one
+    const auto texture = createShadowPoolTexture(pageCountZ);
+    const auto poolSize = shadowPoolPagesPerAxis * shadowPageSize;
+    const auto oldPoolDepth = shadowPoolPageCountZ * shadowPageSize;
+    if (GLAD_GL_VERSION_4_3)
+    {
+        // bricks written by the jump flood shader have to land before they are copied
+        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+        glCopyImageSubData(
+            shadowTexture,
+            GL_TEXTURE_3D,
+            0,
+            0,
+            0,
+            0,
+            texture,
+            GL_TEXTURE_3D,
+            0,
+            0,
+            0,
+            0,
+            poolSize,
+            poolSize,
+            oldPoolDepth);
+    }
+    else
+    {
+        // GL 4.0 copies one layer at a time from a read framebuffer
+        GLint previousReadFramebuffer = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+        GLuint readFramebuffer = 0;
+        glGenFramebuffers(1, &readFramebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        for (int layer = 0; layer < oldPoolDepth; layer++)
+        {
+            glFramebufferTextureLayer(
+                GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, shadowTexture, 0, layer);
+            glCopyTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, layer, 0, 0, poolSize, poolSize);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+        glDeleteFramebuffers(1, &readFramebuffer);
+    }
+
+    glDeleteTextures(1, &shadowTexture);
+    shadowTexture = texture;
+    shadowPoolPageCountZ = pageCountZ;
+}
+
+std::vector<std::int32_t> VSChunkManager::assignShadowPages(const VSShadowBrickLayout& layout)
 {
-    return drawnBlockCount;
+    const auto getBrickIndex = [this, &layout](std::size_t layoutIndex) {
+        const auto brick = layout.firstBrick + glm::ivec3(
+                                                   layoutIndex % layout.brickCount.x,
+                                                   (layoutIndex / layout.brickCount.x) %
+                                                       layout.brickCount.y,
+                                                   layoutIndex / (layout.brickCount.x *
+                                                                  layout.brickCount.y));
+        return brick.x + brick.y * shadowBrickCount.x +
+               static_cast<std::size_t>(brick.z) * shadowBrickCount.x * shadowBrickCount.y;
+    };
+
+    // release pages first so they can be reused right away
+    std::size_t missingPageCount = 0;
+    for (std::size_t i = 0; i < layout.bNeedsPage.size(); i++)
+    {
+        auto& page = shadowBrickPages[getBrickIndex(i)];
+        if (!layout.bNeedsPage[i] && page >= 0)
+        {
+            freeShadowPages.push_back(page);
+            page = -1;
+        }
+        else if (layout.bNeedsPage[i] && page < 0)
+        {
+            missingPageCount++;
+        }
+    }
+
+    const auto getPageCapacity = [](int pageCountZ) {
+        return static_cast<std::size_t>(shadowPoolPagesPerAxis) * shadowPoolPagesPerAxis *
+               pageCountZ;
+    };
+
+    const auto usedPageCount = getShadowPageCount();
+    if (usedPageCount + missingPageCount > getPageCapacity(shadowPoolPageCountZ))
+    {
+        auto pageCountZ = shadowPoolPageCountZ;
+        while (usedPageCount + missingPageCount > getPageCapacity(pageCountZ))
+        {
+            pageCountZ *= 2;
+        }
+
+        const auto oldPageCountZ = shadowPoolPageCountZ;
+        growShadowBrickPool(pageCountZ);
+        if (shadowPoolPageCountZ != oldPageCountZ)
+        {
+            VSLog::Log(
+                VSLog::Category::Core,
+                VSLog::Level::info,
+                "Shadow brick pool grown to {} pages",
+                getPageCapacity(shadowPoolPageCountZ));
+        }
+    }
+
+    std::vector<std::int32_t> pages(layout.bNeedsPage.size(), -1);
+    for (std::size_t i = 0; i < layout.bNeedsPage.size(); i++)
+    {
+        auto& page = shadowBrickPages[getBrickIndex(i)];
+        if (layout.bNeedsPage[i] && page < 0)
+        {
+            if (!freeShadowPages.empty())
+            {
+                page = freeShadowPages.back();
+                freeShadowPages.pop_back();
+            }
+            // if the pool can not grow any further the brick stays uniform
+            else if (
+                static_cast<std::size_t>(nextShadowPage) < getPageCapacity(shadowPoolPageCountZ))
+            {
+                page = nextShadowPage++;
+            }
+        }
+        pages[i] = page;
+    }
+
+    return pages;
 }
 
-std::size_t VSChunkManager::getTotalChunkCount() const
+glm::ivec3 VSChunkManager::getShadowPageOrigin(std::int32_t page) const
 {
-    return glm::compMul(chunkCount);
+    return glm::ivec3(
+               page % shadowPoolPagesPerAxis,
+               (page / shadowPoolPagesPerAxis) % shadowPoolPagesPerAxis,
+               page / (shadowPoolPagesPerAxis * shadowPoolPagesPerAxis)) *
+           shadowPageSize;
 }
 
-std::size_t VSChunkManager::getDrawCallCount() const
+void VSChunkManager::uploadShadowBricks(const VSShadowBricks& bricks)
 {
-    return drawCallCount;
+    const auto& layout = bricks.layout;
+    if (layout.bNeedsPage.empty())
+    {
+        return;
+    }
+
+    const auto pages = assignShadowPages(layout);
+
+    glBindTexture(GL_TEXTURE_3D, shadowTexture);
+
+    std::vector<glm::vec4> brickTableEntries;
+    brickTableEntries.reserve(pages.size());
+
+    const auto pageTexelCount = shadowPageSize * shadowPageSize * shadowPageSize;
+    auto pageDistances = bricks.pageDistances.data();
+    for (std::size_t i = 0; i < pages.size(); i++)
+    {
+        if (pages[i] >= 0)
+        {
+            const auto pageOrigin = getShadowPageOrigin(pages[i]);
+            glTexSubImage3D(
+                GL_TEXTURE_3D,
+                0,
+                pageOrigin.x,
+                pageOrigin.y,
+                pageOrigin.z,
+                shadowPageSize,
+                shadowPageSize,
+                shadowPageSize,
+                GL_RED,
+                GL_FLOAT,
+                pageDistances);
+            brickTableEntries.emplace_back(glm::vec3(pageOrigin / shadowPageSize), 0.F);
+        }
+        else
+        {
+            brickTableEntries.emplace_back(
+                -1.F, bricks.centerDistances[i], 0.F, bricks.minDistances[i]);
+        }
+
+        if (layout.bNeedsPage[i])
+        {
+            pageDistances += pageTexelCount;
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_3D, shadowBrickTable);
+    glTexSubImage3D(
+        GL_TEXTURE_3D,
+        0,
+        layout.firstBrick.x,
+        layout.firstBrick.y,
+        layout.firstBrick.z,
+        layout.brickCount.x,
+        layout.brickCount.y,
+        layout.brickCount.z,
+        GL_RGBA,
+        GL_FLOAT,
+        brickTableEntries.data());
 }
 
-bool VSChunkManager::shouldReinitializeChunks() const
+void VSChunkManager::updateShadowsOnGPU(std::size_t chunkIndex)
 {
-    return bShouldReinitializeChunks.load();
+    // a late CPU result would overwrite the new shadows
+    activeShadowBuildTasks.abandon(chunkIndex);
+
+    buildShadowsOnGPU(chunkIndex);
 }
 
-bool VSChunkManager::isLocationInBounds(const glm::vec3& location) const
+void VSChunkManager::buildShadowsOnGPU(std::size_t chunkIndex)
 {
-    return (
-        (location.x >= -worldSizeHalf.x && location.x < worldSizeHalf.x) &&
-        (location.y >= -worldSizeHalf.y && location.y < worldSizeHalf.y) &&
-        (location.z >= -worldSizeHalf.z && location.z < worldSizeHalf.z));
+    // same region as chunkUpdateShadow, the neighbouring chunks are the halo
+    const auto [regionMin, regionMax] = getShadowRegion(chunkIndex);
+    const auto regionSize = (regionMax - regionMin + 1) * chunkSize;
+    assert(glm::all(glm::lessThanEqual(regionSize, maxJumpFloodRegionSize)));
+
+    // pages are handed out on the CPU, the shader only fills them
+    const auto layout = getShadowBrickLayout(chunkIndex);
+    const auto pages = assignShadowPages(layout);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadowBrickPageBuffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER,
+        pages.size() * sizeof(std::int32_t),
+        pages.data(),
+        GL_STREAM_DRAW);
+
+    // minimum and center distance per brick
+    const GLuint unset = 0xFFFFFFFF;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadowBrickMinDistanceBuffer);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, pages.size() * 2 * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &unset);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, shadowSeedBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, shadowBrickPageBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, shadowBrickMinDistanceBuffer);
+    glBindImageTexture(0, shadowTexture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16F);
+    glBindImageTexture(1, shadowBrickTable, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    shadowJumpFloodShader->uniforms()
+        .setIVec3("chunkSize", chunkSize)
+        .setIVec3("chunkCount", chunkCount)
+        .setInt("seedWordsPerChunk", static_cast<GLint>(getShadowSeedWordsPerChunk()))
+        .setIVec3("worldSize", worldSize)
+        .setIVec3("regionOrigin", regionMin * chunkSize)
+        .setIVec3("regionSize", regionSize)
+        .setInt("brickSize", shadowBrickSize)
+        .setFloat("distanceLimit", shadowDistanceLimit)
+        .setInt("poolPagesPerAxis", shadowPoolPagesPerAxis)
+        .setIVec3("firstBrick", layout.firstBrick)
+        .setIVec3("brickCount", layout.brickCount);
+
+    const auto dispatch = [this](int stage, int stepSize, const glm::ivec3& size) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, jumpFloodBuffers[0]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, jumpFloodBuffers[1]);
+
+        shadowJumpFloodShader->uniforms().setInt("stage", stage).setInt("stepSize", stepSize);
+
+        const auto groupCount = (size + glm::ivec3(jumpFloodWorkGroupSize - 1)) /
+                                glm::ivec3(jumpFloodWorkGroupSize);
+        glDispatchCompute(groupCount.x, groupCount.y, groupCount.z);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // the output of this pass is the input of the next one
+        std::swap(jumpFloodBuffers[0], jumpFloodBuffers[1]);
+    };
+
+    dispatch(0, 0, regionSize);
+
+    int stepSize = 1;
+    while (stepSize * 2 < glm::compMax(regionSize))
+    {
+        stepSize *= 2;
+    }
+    for (; stepSize >= 1; stepSize /= 2)
+    {
+        dispatch(1, stepSize, regionSize);
+    }
+    // one more pass with step size 1 fixes most of the remaining errors
+    dispatch(1, 1, regionSize);
+
+    // only the bricks of the chunk are written, the halo only provides seeds
+    dispatch(2, 0, layout.brickCount * shadowBrickSize + 1);
+    dispatch(3, 0, layout.brickCount);
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 }
 
-VSChunkManager::VSTraceResult
-VSChunkManager::lineTrace(const glm::vec3& start, const glm::vec3& end) const
+std::size_t VSChunkManager::getShadowSeedWordsPerChunk() const
 {
-    const glm::vec3 startToEnd = end - start;
-
-    const float maxRayLength = glm::length(startToEnd);
+    // 16 blocks of 2 bits per word
+    return (getChunkBlockCount() + 15) / 16;
+}
 
-    const auto rayDir = startToEnd / maxRayLength;
+void VSChunkManager::startVisibilityUpdate(std::size_t chunkIndex)
+{
+    auto* const chunk = chunks[chunkIndex];
+    // all edits since the last rebuild are handled by one new update, a running one is abandoned
+    // and its blocks are covered by the new one
+    chunk->updateRegion.add(chunk->rebuildRegion);
+    chunk->rebuildRegion = {};
+    const auto visibilityUpdate = VSVisibilityChunkUpdate::create(
+        [this, region = chunk->updateRegion, sources = getSnapshotSources(chunkIndex)](
+            const std::atomic<bool>& bShouldCancel,
+            std::atomic<bool>& bIsReady,
+            std::size_t chunkIndex) {
+            // only the frozen block data is taken on the main thread, the apron is copied here
+            const auto snapshot = createChunkSnapshot(sources);
+            return this->chunkUpdateVisibility(
+                bShouldCancel, bIsReady, chunkIndex, region, snapshot);
+        },
+        chunkIndex,
+        chunk->generation);
 
-    float t = 0.F;
+    activeVisibilityBuildTasks.add(chunkIndex, visibilityUpdate);
+}
 
-    while (!bShouldReinitializeChunks && t < maxRayLength)
+void VSChunkManager::updateVisibleBlocks(std::size_t chunkIndex)
+{
+    auto* const chunk = chunks[chunkIndex];
+    if (activeVisibilityBuildTasks.get(chunkIndex))
     {
-        const auto samplePos = start + rayDir * t;
-        if (!bShouldReinitializeChunks && isLocationInBounds(samplePos))
+        const auto visiblityTask = activeVisibilityBuildTasks.get(chunkIndex);
+        if (visiblityTask->isReady())
         {
-            const auto blockSample = getBlock(samplePos);
-            if (blockSample != VS_DEFAULT_BLOCK_ID)
+            auto visibilityResult = visiblityTask->getResult();
+            activeVisibilityBuildTasks.remove(chunkIndex);
+
+            // the chunk changed while building, the pending rebuild replaces this result
+            if (visiblityTask->getGeneration() != chunk->generation)
             {
-                const auto centerToHitPos = glm::fract(samplePos) - 0.5F;
+                chunk->rebuildRegion.add(chunk->updateRegion);
+                chunk->updateRegion = {};
+                return;
+            }
+            chunk->updateRegion = {};
 
-                glm::vec3 d = glm::abs(centerToHitPos) - 0.5F;
-                const auto distToSurface = length(glm::max(d, glm::vec3(0.F))) +
-                                           glm::min(glm::max(glm::max(d.x, d.y), d.z), 0.F);
+            // running shadow updates keep the visibility they were started with
+            chunk->bIsBlockVisible = std::move(visibilityResult.bIsBlockVisible);
 
-                auto interSectionPos = samplePos - rayDir * distToSurface;
+            bool bAreInstancesUploaded = false;
+            if (visibilityResult.bIsPartial)
+            {
+                bAreInstancesUploaded = patchVisibleBlockInfos(
+                    chunk, visibilityResult.region, visibilityResult.visibleBlockInfos);
+            }
+            else
+            {
+                chunk->visibleBlockInfos = std::move(visibilityResult.visibleBlockInfos);
+            }
+            if (!visibilityResult.shadowSeeds.empty())
+            {
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, shadowSeedBuffer);
+                glBufferSubData(
+                    GL_SHADER_STORAGE_BUFFER,
+                    (chunkIndex * getShadowSeedWordsPerChunk() +
+                     visibilityResult.shadowSeedOffset) *
+                        sizeof(std::uint32_t),
+                    visibilityResult.shadowSeeds.size() * sizeof(std::uint32_t),
+                    visibilityResult.shadowSeeds.data());
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            }
+            if (meshingMode == VSChunkMeshingMode::Greedy)
+            {
+                uploadMesh(chunk, visibilityResult.meshVertices);
+            }
+            else if (!bAreInstancesUploaded)
+            {
+                uploadVisibleBlockInfos(chunk);
+            }
+            bShouldRebuildCullEntries = true;
+
+            // Update shadows for us and neighbours, the shadow region of a chunk reaches as far.
+            // Distances are capped, so a partial update only reaches the chunks whose shadows
+            // (including the border texels reaching into the next chunk) are close to the region.
+            const auto changedRegion =
+                visibilityResult.bIsPartial
+                    ? visibilityResult.region
+                    : VSChunk::VSBlockRegion{glm::ivec3(0), chunkSize - 1};
+            const auto [regionMin, regionMax] = getShadowRegion(chunkIndex);
+            const auto chunkOrigin = chunkIndexToChunkCoordinates(chunkIndex) * chunkSize;
+            const auto reach = static_cast<int>(shadowDistanceLimit);
+            const auto changedMin = chunkOrigin + changedRegion.min - reach;
+            const auto changedMax = chunkOrigin + changedRegion.max + reach;
+            for (int z = regionMin.z; z <= regionMax.z; z++)
+            {
+                for (int y = regionMin.y; y <= regionMax.y; y++)
+                {
+                    for (int x = regionMin.x; x <= regionMax.x; x++)
+                    {
+                        const auto shadowChunk = glm::ivec3(x, y, z);
+                        const auto shadowMin = shadowChunk * chunkSize - 1;
+                        const auto shadowMax = (shadowChunk + 1) * chunkSize;
+                        if (glm::any(glm::greaterThan(shadowMin, changedMax)) ||
+                            glm::any(glm::lessThan(shadowMax, changedMin)))
+                        {
+                            continue;
+                        }
+                        markChunkShadowsDirty(chunkCoordinatesToChunkIndex(shadowChunk));
+                    }
+                }
+            }
+        }
+    }
+}
 
-                // calc normals
+void VSChunkManager::uploadVisibleBlockInfos(VSChunk* chunk)
+{
+    std::size_t instanceCount = 0;
+    for (std::size_t i = 0; i < faceCombinationCount; i++)
+    {
+        chunk->instanceOffsets[i] = instanceCount;
+        chunk->instanceCapacities[i] = getInstanceCapacity(chunk->visibleBlockInfos[i].size());
+        instanceCount += chunk->instanceCapacities[i];
+    }
 
-                auto normal = glm::vec3(0, 0, 0);
+    // only reallocate if the chunk outgrew its range or wastes most of it
+    if (instanceCount > chunk->instanceAllocation.size ||
+        instanceCount < chunk->instanceAllocation.size / 4)
+    {
+        instanceArena->free(chunk->instanceAllocation);
+        chunk->instanceAllocation = instanceArena->allocate(instanceCount);
+    }
 
-                if (d.x > d.y && d.x > d.z)
+    for (std::size_t i = 0; i < faceCombinationCount; i++)
+    {
+        instanceArena->upload(
+            chunk->instanceAllocation,
+            chunk->instanceOffsets[i],
+            chunk->visibleBlockInfos[i].data(),
+            chunk->visibleBlockInfos[i].size());
+    }
+    updateGeometryCounts(chunk);
+}
+
+void VSChunkManager::updateGeometryCounts(VSChunk* chunk) const
+{
+    chunk->triangleCount = 0;
+    chunk->vertexCount = 0;
+    for (std::size_t i = 0; i < faceCombinationCount; i++)
+    {
+        chunk->triangleCount +=
+            chunk->visibleBlockInfos[i].size() * (cubeMeshRanges[i].indexCount / 3);
+        chunk->vertexCount += chunk->visibleBlockInfos[i].size() * cubeMeshRanges[i].vertexCount;
+    }
+}
+
+void VSChunkManager::uploadMesh(
+    VSChunk* chunk,
+    const std::vector<VSChunk::VSMeshVertex>& meshVertices)
+{
+    const auto vertexCount = meshVertices.size();
+
+    if (vertexCount > chunk->meshAllocation.size || vertexCount < chunk->meshAllocation.size / 4)
+    {
+        meshArena->free(chunk->meshAllocation);
+        chunk->meshAllocation = meshArena->allocate(vertexCount);
+    }
+
+    meshArena->upload(chunk->meshAllocation, 0, meshVertices.data(), vertexCount);
+
+    chunk->meshQuadCount = vertexCount / 4;
+    chunk->triangleCount = chunk->meshQuadCount * 2;
+    chunk->vertexCount = vertexCount;
+
+    ensureQuadIndexCapacity(chunk->meshQuadCount);
+}
+
+void VSChunkManager::ensureQuadIndexCapacity(std::size_t quadCount)
+{
+    if (quadCount <= quadIndexCapacity)
+    {
+        return;
+    }
+
+    quadIndexCapacity = std::max(quadCount, quadIndexCapacity * 2);
+
+    // first triangle 0 1 2, second 0 2 3, the mesher orders the vertices to pick the diagonal
+    std::vector<GLuint> quadIndices;
+    quadIndices.reserve(quadIndexCapacity * 6);
+    for (GLuint quad = 0; quad < quadIndexCapacity; quad++)
+    {
+        for (const GLuint index : {0U, 1U, 2U, 0U, 2U, 3U})
+        {
+            quadIndices.push_back(quad * 4 + index);
+        }
+    }
+
+    // the element buffer binding is part of the vertex array state
+    glBindVertexArray(meshVertexArrayObject);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER,
+        quadIndices.size() * sizeof(GLuint),
+        quadIndices.data(),
+        GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+VSBufferArena* VSChunkManager::getChunkArena() const
+{
+    return meshingMode == VSChunkMeshingMode::Greedy ? meshArena.get() : instanceArena.get();
+}
+
+void VSChunkManager::appendDrawCommands(
+    const VSChunk* chunk,
+    std::vector<VSDrawElementsIndirectCommand>& commands) const
+{
+    if (meshingMode == VSChunkMeshingMode::Greedy)
+    {
+        if (chunk->meshQuadCount != 0)
+        {
+            commands.push_back(
+                {static_cast<GLuint>(chunk->meshQuadCount * 6),
+                 1,
+                 0,
+                 static_cast<GLint>(chunk->meshAllocation.offset),
+                 0});
+        }
+        return;
+    }
+
+    for (std::size_t i = 1; i < faceCombinationCount; i++)
+    {
+        const auto instanceCount = chunk->visibleBlockInfos[i].size();
+        if (instanceCount == 0)
+        {
+            continue;
+        }
+
+        commands.push_back(
+            {cubeMeshRanges[i].indexCount,
+             static_cast<GLuint>(instanceCount),
+             cubeMeshRanges[i].firstIndex,
+             cubeMeshRanges[i].baseVertex,
+             static_cast<GLuint>(chunk->instanceAllocation.offset + chunk->instanceOffsets[i])});
+    }
+}
+
+void VSChunkManager::setMeshAttribPointers() const
+{
+    const auto stride = sizeof(VSChunk::VSMeshVertex);
+
+    glVertexAttribPointer(
+        0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(VSChunk::VSMeshVertex, position));
+    glVertexAttribPointer(
+        1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(VSChunk::VSMeshVertex, normal));
+    glVertexAttribIPointer(
+        2, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(VSChunk::VSMeshVertex, id));
+    glVertexAttribPointer(
+        3, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(VSChunk::VSMeshVertex, lightLevel));
+}
+
+void VSChunkManager::setInstanceAttribPointers(
+    GLuint firstAttribPointer,
+    std::size_t firstInstance) const
+{
+    const auto stride = sizeof(VSChunk::VSVisibleBlockInfo);
+    const auto baseOffset = firstInstance * stride;
+
+    glVertexAttribIPointer(
+        firstAttribPointer,
+        1,
+        GL_UNSIGNED_INT,
+        stride,
+        (void*)(baseOffset + offsetof(VSChunk::VSVisibleBlockInfo, packedLocation)));
+    glVertexAttribIPointer(
+        firstAttribPointer + 1,
+        1,
+        GL_UNSIGNED_INT,
+        stride,
+        (void*)(baseOffset + offsetof(VSChunk::VSVisibleBlockInfo, packedBlock)));
+}
+
+VSChunkManager::VSSnapshotSources VSChunkManager::getSnapshotSources(std::size_t chunkIndex) const
+{
+    VSSnapshotSources sources;
+    sources.bIsBlockVisible = chunks[chunkIndex]->bIsBlockVisible;
+
+    const auto chunkCoordinates = chunkIndexToChunkCoordinates(chunkIndex);
+    for (int offsetZ = -1; offsetZ <= 1; offsetZ++)
+    {
+        for (int offsetY = -1; offsetY <= 1; offsetY++)
+        {
+            for (int offsetX = -1; offsetX <= 1; offsetX++)
+            {
+                const auto offset = glm::ivec3(offsetX, offsetY, offsetZ);
+                const auto neighbourCoordinates = chunkCoordinates + offset;
+                if (glm::any(glm::lessThan(neighbourCoordinates, glm::ivec3(0))) ||
+                    glm::any(glm::greaterThanEqual(neighbourCoordinates, chunkCount)))
                 {
-                    normal = {glm::sign(centerToHitPos.x) * 1.F, 0.F, 0.F};
-                    interSectionPos.x = glm::round(interSectionPos.x);
-                    if (centerToHitPos.x < 0)
-                    {
-                        interSectionPos.x -= 0.00001F;
-                    }
+                    continue;
                 }
+                sources.blockData[getNeighbourhoodIndex(offset)] =
+                    freezeBlockData(chunkCoordinatesToChunkIndex(neighbourCoordinates));
+            }
+        }
+    }
+    return sources;
+}
 
-                if (d.y > d.x && d.y > d.z)
+VSChunkManager::VSChunkSnapshot VSChunkManager::createChunkSnapshot(
+    const VSSnapshotSources& sources) const
+{
+    VSChunkSnapshot snapshot;
+    snapshot.size = chunkSize + 2;
+    const auto paddedBlockCount = static_cast<std::size_t>(glm::compMul(snapshot.size));
+    snapshot.blocks.resize(paddedBlockCount, VS_DEFAULT_BLOCK_ID);
+    snapshot.light.resize(paddedBlockCount, 0);
+
+    // blocks of the neighbour at offset that touch the chunk, in the neighbour's block coordinates
+    const auto getCopyRange = [](int offset, int size) {
+        return offset < 0   ? glm::ivec2(size - 1, size - 1)
+               : offset > 0 ? glm::ivec2(0, 0)
+                            : glm::ivec2(0, size - 1);
+    };
+
+    snapshot.bIsBlockVisible = sources.bIsBlockVisible;
+
+    const auto& neighbourhoodBlockData = sources.blockData;
+    for (int offsetZ = -1; offsetZ <= 1; offsetZ++)
+    {
+        for (int offsetY = -1; offsetY <= 1; offsetY++)
+        {
+            for (int offsetX = -1; offsetX <= 1; offsetX++)
+            {
+                const auto offset = glm::ivec3(offsetX, offsetY, offsetZ);
+                const auto& neighbourBlockData =
+                    neighbourhoodBlockData[getNeighbourhoodIndex(offset)];
+                if (!neighbourBlockData)
                 {
-                    normal = {0.F, glm::sign(centerToHitPos.y) * 1.F, 0.F};
-                    interSectionPos.y = glm::round(interSectionPos.y);
-                    if (centerToHitPos.y < 0)
-                    {
-                        interSectionPos.y -= 0.00001F;
-                    }
+                    continue;
                 }
 
-                if (d.z > d.x && d.z > d.y)
+                const auto rangeX = getCopyRange(offsetX, chunkSize.x);
+                const auto rangeY = getCopyRange(offsetY, chunkSize.y);
+                const auto rangeZ = getCopyRange(offsetZ, chunkSize.z);
+                const auto rowLength = static_cast<std::size_t>(rangeX.y - rangeX.x + 1);
+                const auto neighbourOffset = offset * chunkSize;
+                for (int z = rangeZ.x; z <= rangeZ.y; z++)
                 {
-                    normal = {0.F, 0.F, glm::sign(centerToHitPos.z) * 1.F};
-                    interSectionPos.z = glm::round(interSectionPos.z);
-                    if (centerToHitPos.z < 0)
+                    for (int y = rangeY.x; y <= rangeY.y; y++)
                     {
-                        interSectionPos.z -= 0.00001F;
+                        const auto rowStart = glm::ivec3(rangeX.x, y, z);
+                        const auto sourceIndex = blockCoordinatesToBlockIndex(rowStart);
+                        const auto targetIndex = snapshot.getIndex(rowStart + neighbourOffset);
+                        neighbourBlockData->sections.copyRowBlocks(
+                            sourceIndex, rowLength, snapshot.blocks.data() + targetIndex);
+                        neighbourBlockData->sections.copyRowLight(
+                            sourceIndex, rowLength, snapshot.light.data() + targetIndex);
                     }
                 }
-
-                return VSChunkManager::VSTraceResult{true, interSectionPos, normal, blockSample};
             }
         }
-        t += 0.0075F;
     }
 
-    return {false, {}, {}, VS_DEFAULT_BLOCK_ID};
-}
+    // Solid sections only show blocks next to air. Blocks at the world border only show below
+    // air, so the world outside of the chunks does not count.
+    const auto isSolidSection = [](const VSChunkSections& sections, std::size_t sectionIndex) {
+        return sections.isSectionUniform(sectionIndex) &&
+               sections.getSectionBlock(sectionIndex) != VS_DEFAULT_BLOCK_ID;
+    };
+    const auto& aboveBlockData = neighbourhoodBlockData[getNeighbourhoodIndex({0, 1, 0})];
+    const auto& belowBlockData = neighbourhoodBlockData[getNeighbourhoodIndex({0, -1, 0})];
+    const auto& sections = neighbourhoodBlockData[getNeighbourhoodIndex({0, 0, 0})]->sections;
+    const auto sectionCount = sections.getSectionCount();
+    snapshot.bIsSectionHidden.resize(sectionCount, false);
+    for (std::size_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex++)
+    {
+        if (sections.isSectionUniform(sectionIndex) &&
+            sections.getSectionBlock(sectionIndex) == VS_DEFAULT_BLOCK_ID)
+        {
+            snapshot.bIsSectionHidden[sectionIndex] = true;
+            continue;
+        }
 
-VSChunkManager::VSWorldData VSChunkManager::getData() const
-{
-    VSChunkManager::VSWorldData worldData{};
+        // the section above continues in the chunk above, the top of the world is open
+        const bool bIsSolidAbove =
+            sectionIndex + 1 < sectionCount
+                ? isSolidSection(sections, sectionIndex + 1)
+                : aboveBlockData && isSolidSection(aboveBlockData->sections, 0);
+        const bool bIsSolidBelow =
+            sectionIndex > 0
+                ? isSolidSection(sections, sectionIndex - 1)
+                : !belowBlockData || isSolidSection(belowBlockData->sections, sectionCount - 1);
+        bool bIsEnclosed = isSolidSection(sections, sectionIndex) && bIsSolidAbove && bIsSolidBelow;
+        for (const auto& offset :
+             {glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0), glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)})
+        {
+            const auto& neighbourBlockData = neighbourhoodBlockData[getNeighbourhoodIndex(offset)];
+            bIsEnclosed =
+                bIsEnclosed &&
+                (!neighbourBlockData || isSolidSection(neighbourBlockData->sections, sectionIndex));
+        }
+        snapshot.bIsSectionHidden[sectionIndex] = bIsEnclosed;
+    }
 
-    worldData.chunkSize = chunkSize;
-    worldData.chunkCount = getChunkCount();
+    const auto& occupancy = neighbourhoodBlockData[getNeighbourhoodIndex({0, 0, 0})]->occupancy;
+    if (occupancy.empty())
+    {
+        return snapshot;
+    }
 
-    // Write BlockIDs to vector
-    worldData.blocks = std::vector<VSBlockID>();
+    const auto getNeighbourOccupancy =
+        [&neighbourhoodBlockData](
+            const glm::ivec3& offset) -> const std::pmr::vector<std::uint64_t>* {
+        const auto& neighbourBlockData = neighbourhoodBlockData[getNeighbourhoodIndex(offset)];
+        return neighbourBlockData ? &neighbourBlockData->occupancy : nullptr;
+    };
+
+    const auto* rightOccupancy = getNeighbourOccupancy({1, 0, 0});
+    const auto* leftOccupancy = getNeighbourOccupancy({-1, 0, 0});
+    const auto* aboveOccupancy = getNeighbourOccupancy({0, 1, 0});
+    const auto* belowOccupancy = getNeighbourOccupancy({0, -1, 0});
+    const auto* frontOccupancy = getNeighbourOccupancy({0, 0, 1});
+    const auto* backOccupancy = getNeighbourOccupancy({0, 0, -1});
+
+    const auto width = chunkSize.x;
+    const auto height = chunkSize.y;
+    const auto depth = chunkSize.z;
+
+    // rows outside of the world stay empty, world border blocks are handled by the mesher anyway
+    const auto paddedStride = height + 2;
+    auto& paddedRows = snapshot.paddedRows;
+    paddedRows.resize(paddedStride * (depth + 2), 0);
+    for (int z = 0; z < depth; z++)
+    {
+        const auto paddedColumn = paddedRows.begin() + (z + 1) * paddedStride;
+        std::copy_n(occupancy.begin() + z * height, height, paddedColumn + 1);
+        if (aboveOccupancy != nullptr)
+        {
+            paddedColumn[height + 1] = (*aboveOccupancy)[z * height];
+        }
+        if (belowOccupancy != nullptr)
+        {
+            paddedColumn[0] = (*belowOccupancy)[z * height + height - 1];
+        }
+    }
+    if (frontOccupancy != nullptr)
+    {
+        std::copy_n(
+            frontOccupancy->begin(), height, paddedRows.begin() + (depth + 1) * paddedStride + 1);
+    }
+    if (backOccupancy != nullptr)
+    {
+        std::copy_n(backOccupancy->begin() + (depth - 1) * height, height, paddedRows.begin() + 1);
+    }
+
+    snapshot.plusXEdges.resize(occupancy.size(), 0);
+    snapshot.minusXEdges.resize(occupancy.size(), 0);
+    for (std::size_t row = 0; row < occupancy.size(); row++)
+    {
+        if (rightOccupancy != nullptr)
+        {
+            snapshot.plusXEdges[row] = ((*rightOccupancy)[row] & 1U) << (width - 1);
+        }
+        if (leftOccupancy != nullptr)
+        {
+            snapshot.minusXEdges[row] = ((*leftOccupancy)[row] >> (width - 1)) & 1U;
+        }
+    }
+
+    return snapshot;
+}
+
+VSChunkManager::VSChunk::VSVisibilityResult VSChunkManager::chunkUpdateVisibility(
+    const std::atomic<bool>& bShouldCancel,
+    std::atomic<bool>& bIsReady,
+    std::size_t chunkIndex,
+    const VSChunk::VSBlockRegion& region,
+    const VSChunkSnapshot& snapshot) const
+{
+    const auto chunkBlockCount = getChunkBlockCount();
 
-    for (const auto* chunk : chunks)
+    // the greedy mesh is always built from all faces of the chunk
+    if (meshingMode == VSChunkMeshingMode::CubeInstancing &&
+        region.getBlockCount() * partialRebuildMaxBlockFraction <= chunkBlockCount)
     {
-        worldData.blocks.insert(worldData.blocks.end(), chunk->blocks.begin(), chunk->blocks.end());
+        return chunkUpdateVisibleRegion(bShouldCancel, bIsReady, chunkIndex, region, snapshot);
     }
 
-    return worldData;
-}
+    auto result = VSChunkManager::VSChunk::VSVisibilityResult();
 
-void VSChunkManager::initFromData(const VSWorldData& data)
-{
-    setChunkDimensions(data.chunkSize, data.chunkCount);
-    worldDataFromFile = data;
-    bShouldInitializeFromData = true;
-}
+    const auto visibleBlockFaces = getVisibleBlockFaces(bShouldCancel, chunkIndex, snapshot);
 
-void VSChunkManager::initializeChunks()
-{
-    bool expected = true;
-    if (bShouldReinitializeChunks.load() == expected)
-    {
-        chunkSize = newChunkSize;
-        chunkCount = newChunkCount;
-        worldSize = newWorldSize;
-        worldSizeHalf = newWorldSizeHalf;
+    auto bIsBlockVisible = createBlockVisibility();
+    bIsBlockVisible->assign(chunkBlockCount, false);
+
+    // the greedy mesher keeps the full corner light for ambient occlusion
+    std::vector<std::array<std::uint32_t, 6>> visibleBlockLights;
+    visibleBlockLights.reserve(visibleBlockFaces.size());
 
-        for (const auto& [chunk, shadowBuildUpdate] : activeShadowBuildTasks)
+    for (const auto& [blockIndex, blockType] : visibleBlockFaces)
+    {
+        if (bShouldCancel)
         {
-            shadowBuildUpdate->cancel();
+            return {};
         }
-        activeShadowBuildTasks.clear();
 
-        for (const auto& [chunk, visibilityBuildUpdate] : activeVisibilityBuildTasks)
+        const auto blockCoordinates = blockIndexToBlockCoordinates(blockIndex);
+        const auto lighInfo = getLightInformation(snapshot, blockCoordinates);
+
+        const auto blockInfo = VSChunk::VSVisibleBlockInfo{
+            packLocation(chunkIndex, blockCoordinates),
+            packBlock(snapshot.blocks[snapshot.getIndex(blockCoordinates)], lighInfo)};
+        result.visibleBlockInfos[blockType].emplace_back(blockInfo);
+        visibleBlockLights.push_back(lighInfo);
+        (*bIsBlockVisible)[blockIndex] = true;
+    }
+
+    result.shadowSeeds = getShadowSeeds(snapshot, *bIsBlockVisible, 0, getChunkBlockCount() - 1);
+    result.bIsBlockVisible = std::move(bIsBlockVisible);
+
+    if (meshingMode == VSChunkMeshingMode::Greedy)
+    {
+        if (bShouldCancel)
         {
-            visibilityBuildUpdate->cancel();
+            return {};
         }
-        activeVisibilityBuildTasks.clear();
+        result.meshVertices =
+            buildGreedyMesh(visibleBlockFaces, visibleBlockLights, chunkIndex, snapshot);
+    }
 
-        for (auto* chunk : chunks)
+    bIsReady = true;
+
+    return result;
+};
+
+VSChunkManager::VSChunk::VSVisibilityResult VSChunkManager::chunkUpdateVisibleRegion(
+    const std::atomic<bool>& bShouldCancel,
+    std::atomic<bool>& bIsReady,
+    std::size_t chunkIndex,
+    const VSChunk::VSBlockRegion& region,
+    const VSChunkSnapshot& snapshot) const
+{
+    auto result = VSChunkManager::VSChunk::VSVisibilityResult();
+    result.bIsPartial = true;
+    result.region = region;
+    // blocks outside the region keep their visibility
+    result.bIsBlockVisible = createBlockVisibility();
+    *result.bIsBlockVisible = *snapshot.bIsBlockVisible;
+
+    for (int z = region.min.z; z <= region.max.z; z++)
+    {
+        if (bShouldCancel)
         {
-            deleteChunk(chunk);
+            return {};
         }
-        chunks.clear();
-        chunks.resize(chunkCount.x * chunkCount.y);
 
-        for (int y = 0; y < chunkCount.x; y++)
+        for (int y = region.min.y; y <= region.max.y; y++)
         {
-            for (int x = 0; x < chunkCount.x; x++)
+            for (int x = region.min.x; x <= region.max.x; x++)
             {
-                VSChunk* newChunk = createChunk();
-                newChunk->chunkLocation =
-                    glm::vec3(
-                        chunkSize.x * (static_cast<float>(x) + 0.5F),
-                        0.F,
-                        chunkSize.z * (static_cast<float>(y) + 0.5F)) -
-                    glm::vec3(chunkSize.x * chunkCount.x, 0.F, chunkSize.z * chunkCount.y) / 2.F;
-                chunks[y * chunkCount.x + x] = newChunk;
+                const auto blockCoordinates = glm::ivec3(x, y, z);
+                const auto blockID = snapshot.blocks[snapshot.getIndex(blockCoordinates)];
+
+                const auto blockType = blockID != VS_DEFAULT_BLOCK_ID
+                                           ? isBlockVisible(snapshot, chunkIndex, blockCoordinates)
+                                           : std::uint8_t{0};
+                (*result.bIsBlockVisible)[blockCoordinatesToBlockIndex(blockCoordinates)] =
+                    blockType != 0;
+                if (blockType == 0)
+                {
+                    continue;
+                }
+
+                result.visibleBlockInfos[blockType].push_back(
+                    {packLocation(chunkIndex, blockCoordinates),
+                     packBlock(blockID, getLightInformation(snapshot, blockCoordinates))});
             }
         }
-
-        glDeleteTextures(1, &shadowTexture);
-
-        glGenTextures(1, &shadowTexture);
-        glBindTexture(GL_TEXTURE_3D, shadowTexture);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
-        glm::vec3 borderColor(std::numeric_limits<float>::max());
-        glTexParameterfv(GL_TEXTURE_3D, GL_TEXTURE_BORDER_COLOR, &borderColor[0]);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexImage3D(
-            GL_TEXTURE_3D,
-            0,
-            GL_R16F,
-            worldSize.x,
-            worldSize.y,
-            worldSize.z,
-            0,
-            GL_RED,
-            GL_FLOAT,
-            nullptr);
-
-        bShouldReinitializeChunks.compare_exchange_weak(expected, false);
     }
-}
 
-VSChunkManager::VSChunk* VSChunkManager::createChunk() const
-{
-    auto* chunk = new VSChunk();
+    // only the seed words holding blocks of the region are uploaded
+    const auto firstBlockIndex = blockCoordinatesToBlockIndex(region.min);
+    result.shadowSeeds = getShadowSeeds(
+        snapshot,
+        *result.bIsBlockVisible,
+        firstBlockIndex,
+        blockCoordinatesToBlockIndex(region.max));
+    result.shadowSeedOffset = firstBlockIndex / 16;
 
-    chunk->blocks.resize(getChunkBlockCount(), VS_DEFAULT_BLOCK_ID);
-    chunk->bIsBlockVisible.resize(getChunkBlockCount(), false);
-    chunk->lightLevel.resize(getChunkBlockCount(), 0.F);
+    bIsReady = true;
 
-    return chunk;
+    return result;
 }
 
-void VSChunkManager::deleteChunk(VSChunk* chunk)
+bool VSChunkManager::patchVisibleBlockInfos(
+    VSChunk* chunk,
+    const VSChunk::VSBlockRegion& region,
+    const VSChunk::VSVisibleBlockInfos& regionBlockInfos)
 {
-    delete chunk;
-}
+    const auto isInRegion = [this, &region](const VSChunk::VSVisibleBlockInfo& blockInfo) {
+        return region.contains(unpackBlockCoordinates(blockInfo.packedLocation));
+    };
 
-void VSChunkManager::updateShadows(std::size_t chunkIndex)
-{
-    auto* const chunk = chunks[chunkIndex];
-    bool expectedShadows = true;
-    // check if dirty after checking for shadows to avoid race conditions
-    // only allow hardware_concurrency active chunk updates
-    if (activeShadowBuildTasks.size() < maxShadowUpdateThreads &&
-        chunk->bShouldRebuildShadows.compare_exchange_weak(expectedShadows, false))
+    bool bDoAllFit = true;
+    for (std::size_t i = 0; i < faceCombinationCount && bDoAllFit; i++)
     {
-        if (activeShadowBuildTasks.count(chunk) != 0)
+        const auto& visibleBlockInfos = chunk->visibleBlockInfos[i];
+        const auto removedCount = static_cast<std::size_t>(
+            std::count_if(visibleBlockInfos.begin(), visibleBlockInfos.end(), isInRegion));
+        bDoAllFit = visibleBlockInfos.size() - removedCount + regionBlockInfos[i].size() <=
+                    chunk->instanceCapacities[i];
+    }
+
+    if (!bDoAllFit)
+    {
+        for (std::size_t i = 0; i < faceCombinationCount; i++)
         {
-            activeShadowBuildTasks[chunk]->cancel();
-            activeShadowBuildTasks.erase(chunk);
+            auto& visibleBlockInfos = chunk->visibleBlockInfos[i];
+            visibleBlockInfos.erase(
+                std::remove_if(visibleBlockInfos.begin(), visibleBlockInfos.end(), isInRegion),
+                visibleBlockInfos.end());
+            visibleBlockInfos.insert(
+                visibleBlockInfos.end(), regionBlockInfos[i].begin(), regionBlockInfos[i].end());
         }
-
-        const auto shadowUpdate = VSShadwoChunkUpdate::create(
-            [this](
-                const std::atomic<bool>& bShouldCancel,
-                std::atomic<bool>& bIsReady,
-                std::size_t chunkIndex) {
-                return this->chunkUpdateShadow(bShouldCancel, bIsReady, chunkIndex);
-            },
-            chunkIndex);
-
-        activeShadowBuildTasks.emplace(chunk, shadowUpdate);
+        return false;
     }
 
-    if (activeShadowBuildTasks.count(chunk) != 0)
+    // entries of the region are overwritten in place, so only those and the ones moved into
+    // their holes are uploaded
+    std::vector<std::size_t> changedIndices;
+    for (std::size_t i = 0; i < faceCombinationCount; i++)
     {
-        const auto shadowTask = activeShadowBuildTasks[chunk];
-        if (shadowTask->isReady())
+        auto& visibleBlockInfos = chunk->visibleBlockInfos[i];
+        const auto& newBlockInfos = regionBlockInfos[i];
+        std::size_t newIndex = 0;
+        changedIndices.clear();
+
+        for (std::size_t index = 0; index < visibleBlockInfos.size(); index++)
         {
-            const auto chunkDistanceField = shadowTask->getResult();
-            activeShadowBuildTasks.erase(chunk);
+            if (!isInRegion(visibleBlockInfos[index]))
+            {
+                continue;
+            }
+            if (newIndex < newBlockInfos.size())
+            {
+                visibleBlockInfos[index] = newBlockInfos[newIndex++];
+                changedIndices.push_back(index);
+                continue;
+            }
 
-            const auto textureBlockLocation = chunk->chunkLocation +
-                                              (glm::vec3(worldSize.x, 0.F, worldSize.z) / 2.F) -
-                                              (glm::vec3(chunkSize.x, 0.F, chunkSize.z) / 2.F);
+            // no new entries left, the last entry outside the region fills the hole
+            while (visibleBlockInfos.size() > index + 1 && isInRegion(visibleBlockInfos.back()))
+            {
+                visibleBlockInfos.pop_back();
+            }
+            if (visibleBlockInfos.size() == index + 1)
+            {
+                visibleBlockInfos.pop_back();
+                break;
+            }
+            visibleBlockInfos[index] = visibleBlockInfos.back();
+            visibleBlockInfos.pop_back();
+            changedIndices.push_back(index);
+        }
 
-            glBindTexture(GL_TEXTURE_3D, shadowTexture);
+        for (; newIndex < newBlockInfos.size(); newIndex++)
+        {
+            changedIndices.push_back(visibleBlockInfos.size());
+            visibleBlockInfos.push_back(newBlockInfos[newIndex]);
+        }
 
-            glTexSubImage3D(
-                GL_TEXTURE_3D,
-                0,
-                textureBlockLocation.x,
-                textureBlockLocation.y,
-                textureBlockLocation.z,
-                chunkSize.x,
-                chunkSize.y,
-                chunkSize.z,
-                GL_RED,
-                GL_FLOAT,
-                chunkDistanceField.data());
+        // neighbouring entries are uploaded together
+        for (std::size_t first = 0; first < changedIndices.size();)
+        {
+            auto last = first;
+            while (last + 1 < changedIndices.size() &&
+                   changedIndices[last + 1] == changedIndices[last] + 1)
+            {
+                last++;
+            }
+            instanceArena->upload(
+                chunk->instanceAllocation,
+                chunk->instanceOffsets[i] + changedIndices[first],
+                visibleBlockInfos.data() + changedIndices[first],
+                last - first + 1);
+            first = last + 1;
         }
     }
+    updateGeometryCounts(chunk);
+    return true;
 }
 
-std::vector<float> VSChunkManager::chunkUpdateShadow(
-    const std::atomic<bool>& bShouldCancel,
-    std::atomic<bool>& bIsReady,
-    std::size_t chunkIndex) const
+std::vector<std::uint32_t> VSChunkManager::getShadowSeeds(
+    const VSChunkSnapshot& snapshot,
+    const VSChunk::VSBlockVisibility& bIsBlockVisible,
+    std::size_t firstBlockIndex,
+    std::size_t lastBlockIndex) const
 {
-    const auto chunkCoords = chunkIndexToChunkCoordinates(chunkIndex);
-
-    std::vector<VSChunk::VSVisibleBlockInfo> relevantVisibleBlocks;
+    if (!shadowJumpFloodShader)
+    {
+        return {};
+    }
 
-    // TODO this wont work anymore if the terrain becomes more complex
-    // overhangs or floating stuff will cause issues
-    const std::int32_t chunkRadius =
-        1;  // glm::min(1, 128 / static_cast<int>(glm::sqrt(chunkSize.x * chunkSize.x +
-    // chunkSize.z * chunkSize.z)));
+    // whole words, the blocks sharing a word with the range are written as well
+    const auto firstWord = firstBlockIndex / 16;
+    const auto wordCount = lastBlockIndex / 16 - firstWord + 1;
+    const auto endBlockIndex = std::min((firstWord + wordCount) * 16, getChunkBlockCount());
 
-    for (int x = glm::max(chunkCoords.x - chunkRadius, 0);
-         x <= glm::min(chunkCoords.x + chunkRadius, chunkCount.x - 1);
-         x++)
+    std::vector<std::uint32_t> shadowSeeds(wordCount, 0);
+    auto blockCoordinates = blockIndexToBlockCoordinates(firstWord * 16);
+    // rows are contiguous in the snapshot as well
+    auto snapshotIndex = snapshot.getIndex(blockCoordinates);
+    for (auto blockIndex = firstWord * 16; blockIndex < endBlockIndex; blockIndex++)
     {
-        for (int y = glm::max(chunkCoords.y - chunkRadius, 0);
-             y <= glm::min(chunkCoords.y + chunkRadius, chunkCount.y - 1);
-             y++)
+        const std::uint32_t seedBits =
+            (bIsBlockVisible[blockIndex] ? 1U : 0U) |
+            (snapshot.blocks[snapshotIndex++] != VS_DEFAULT_BLOCK_ID ? 2U : 0U);
+        shadowSeeds[blockIndex / 16 - firstWord] |= seedBits << ((blockIndex % 16) * 2);
+
+        if (++blockCoordinates.x == chunkSize.x)
         {
-            // abort calculations if canceled
-            if (bShouldCancel)
-            {
-                return {};
-            }
-            const auto* neighbourChunk = chunks[chunkCoordinatesToChunkIndex({x, y})];
-            for (const auto& visibleBlockInfos : neighbourChunk->visibleBlockInfos)
+            blockCoordinates.x = 0;
+            if (++blockCoordinates.y == chunkSize.y)
             {
-                relevantVisibleBlocks.insert(
-                    relevantVisibleBlocks.end(),
-                    visibleBlockInfos.begin(),
-                    visibleBlockInfos.end());
+                blockCoordinates.y = 0;
+                blockCoordinates.z++;
             }
+            snapshotIndex = snapshot.getIndex(blockCoordinates);
         }
     }
+    return shadowSeeds;
+}
 
-    auto* const chunk = chunks[chunkIndex];
-
-    std::vector<float> chunkDistanceField;
-    chunkDistanceField.resize(getChunkBlockCount());
-
-    const auto chunkToWorld = chunk->chunkLocation + glm::vec3(0.5F) - glm::vec3(chunkSize) / 2.F;
-
-    for (std::size_t blockIndex = 0; blockIndex < getChunkBlockCount(); blockIndex++)
+std::vector<VSChunkManager::VSChunk::VSMeshVertex> VSChunkManager::buildGreedyMesh(
+    const std::vector<std::pair<std::size_t, std::uint8_t>>& visibleBlockFaces,
+    const std::vector<std::array<std::uint32_t, 6>>& visibleBlockLights,
+    std::size_t chunkIndex,
+    const VSChunkSnapshot& snapshot) const
+{
+    struct VSFaceCell
     {
-        // abort calculations if canceled
-        if (bShouldCancel)
-        {
-            return {};
-        }
-        glm::vec3 samplePos = chunkToWorld + glm::vec3(blockIndexToBlockCoordinates(blockIndex));
+        std::uint32_t light = 0;
+        VSBlockID id = VS_DEFAULT_BLOCK_ID;
+        bool bIsSet = false;
+    };
 
-        float distance = std::numeric_limits<float>::max();
+    struct VSFaceDirection
+    {
+        VSCubeFace face;
+        // index into the light array of getLightInformation
+        std::size_t lightIndex;
+        int normalAxis;
+        // light bytes are indexed by u + 2 * v
+        int uAxis;
+        int vAxis;
+        float normalSign;
+    };
+
+    static constexpr std::array<VSFaceDirection, 6> faceDirections = {{
+        {Right, 0, 0, 1, 2, 1.F},
+        {Left, 1, 0, 1, 2, -1.F},
+        {Top, 2, 1, 0, 2, 1.F},
+        {Bottom, 3, 1, 0, 2, -1.F},
+        {Front, 4, 2, 0, 1, 1.F},
+        {Back, 5, 2, 0, 1, -1.F},
+    }};
+
+    const auto chunkMin = chunks[chunkIndex]->chunkLocation - glm::vec3(chunkSize) / 2.F;
+
+    std::vector<VSChunk::VSMeshVertex> vertices;
+    // every set cell is cleared again once it is part of a quad
+    std::vector<VSFaceCell> cells(getChunkBlockCount());
+
+    for (const auto& direction : faceDirections)
+    {
+        // hidden sections have no faces to merge
+        const auto isHidden = [&snapshot](int axis, int coordinate) {
+            return axis == 1 && snapshot.isSectionHidden(coordinate);
+        };
 
-        if (chunk->blocks[blockIndex] != VS_DEFAULT_BLOCK_ID)
+        for (std::size_t i = 0; i < visibleBlockFaces.size(); i++)
         {
-            if (chunk->bIsBlockVisible[blockIndex])
-            {
-                distance = 0.F;
-            }
-            else
+            const auto [blockIndex, faceMask] = visibleBlockFaces[i];
+            if ((faceMask & (1U << direction.face)) != 0)
             {
-                distance = -0.5F;
+                cells[blockIndex] = {
+                    visibleBlockLights[i][direction.lightIndex],
+                    snapshot.blocks[snapshot.getIndex(blockIndexToBlockCoordinates(blockIndex))],
+                    true};
             }
         }
-        else
+
+        const auto cellAt = [&](int slice, int u, int v) -> VSFaceCell& {
+            glm::ivec3 blockCoordinates;
+            blockCoordinates[direction.normalAxis] = slice;
+            blockCoordinates[direction.uAxis] = u;
+            blockCoordinates[direction.vAxis] = v;
+            return cells[blockCoordinatesToBlockIndex(blockCoordinates)];
+        };
+
+        const auto canMerge = [](const VSFaceCell& cell, const VSFaceCell& other) {
+            return other.bIsSet && other.id == cell.id && other.light == cell.light;
+        };
+
+        // the counter clockwise corner order depends on the handedness of the u/v basis
+        const bool bIsCounterClockwise =
+            (direction.normalAxis != 1) == (direction.normalSign > 0.F);
+        const std::array<glm::ivec2, 4> corners =
+            bIsCounterClockwise
+                ? std::array<glm::ivec2, 4>{{{0, 0}, {1, 0}, {1, 1}, {0, 1}}}
+                : std::array<glm::ivec2, 4>{{{0, 0}, {0, 1}, {1, 1}, {1, 0}}};
+
+        const auto sizeU = chunkSize[direction.uAxis];
+        const auto sizeV = chunkSize[direction.vAxis];
+
+        for (int slice = 0; slice < chunkSize[direction.normalAxis]; slice++)
         {
-            for (const auto& blockCandidate : relevantVisibleBlocks)
+            if (isHidden(direction.normalAxis, slice))
             {
-                distance =
-                    glm::min(distance, glm::length2(samplePos - blockCandidate.locationWorldSpace));
+                continue;
             }
-            distance = glm::sqrt(distance);
-        }
 
-        chunkDistanceField[blockIndex] = distance;
-    }
+            for (int v = 0; v < sizeV; v++)
+            {
+                if (isHidden(direction.vAxis, v))
+                {
+                    continue;
+                }
 
-    bIsReady = true;
+                for (int u = 0; u < sizeU; u++)
+                {
+                    if (isHidden(direction.uAxis, u))
+                    {
+                        continue;
+                    }
 
-    return chunkDistanceField;
-}
+                    const auto cell = cellAt(slice, u, v);
+                    if (!cell.bIsSet)
+                    {
+                        continue;
+                    }
 
-void VSChunkManager::updateVisibleBlocks(std::size_t chunkIndex)
-{
-    auto* const chunk = chunks[chunkIndex];
-    bool bIsDirtyExpected = true;
-    // check if dirty after checking for shadows to avoid race conditions
-    // only allow hardware_concurrency active chunk updates
-    if (activeVisibilityBuildTasks.size() < maxShadowUpdateThreads &&
-        chunk->bIsDirty.compare_exchange_weak(bIsDirtyExpected, false))
-    {
-        if (activeVisibilityBuildTasks.count(chunk) != 0)
-        {
-            activeVisibilityBuildTasks[chunk]->cancel();
-            activeVisibilityBuildTasks.erase(chunk);
-        }
+                    int width = 1;
+                    int height = 1;
 
-        const auto visibilityUpdate = VSVisibilityChunkUpdate::create(
-            [this](
-                const std::atomic<bool>& bShouldCancel,
-                std::atomic<bool>& bIsReady,
-                std::size_t chunkIndex) {
-                return this->chunkUpdateVisibility(bShouldCancel, bIsReady, chunkIndex);
-            },
-            chunkIndex);
+                    // faces with differing corner light keep their own quad to preserve AO
+                    const auto cornerLight = cell.light & 0xFFU;
+                    if (cell.light == cornerLight * 0x01010101U)
+                    {
+                        while (u + width < sizeU && canMerge(cell, cellAt(slice, u + width, v)))
+                        {
+                            width++;
+                        }
 
-        activeVisibilityBuildTasks.emplace(chunk, visibilityUpdate);
-    }
+                        bool bCanGrow = true;
+                        while (bCanGrow && v + height < sizeV)
+                        {
+                            for (int du = 0; du < width && bCanGrow; du++)
+                            {
+                                bCanGrow = canMerge(cell, cellAt(slice, u + du, v + height));
+                            }
+                            if (bCanGrow)
+                            {
+                                height++;
+                            }
+                        }
+                    }
 
-    if (activeVisibilityBuildTasks.count(chunk) != 0)
-    {
-        const auto visiblityTask = activeVisibilityBuildTasks[chunk];
-        if (visiblityTask->isReady())
-        {
-            chunk->visibleBlockInfos = visiblityTask->getResult();
-            activeVisibilityBuildTasks.erase(chunk);
+                    for (int dv = 0; dv < height; dv++)
+                    {
+                        for (int du = 0; du < width; du++)
+                        {
+                            cellAt(slice, u + du, v + dv).bIsSet = false;
+                        }
+                    }
 
-            // update shadows for us and neighbours
-            // TODO duplicate code (see updateShadows)
-            const auto chunkCoords = chunkIndexToChunkCoordinates(chunkIndex);
-            const std::int32_t chunkRadius = 1;
-            for (int x = glm::max(chunkCoords.x - chunkRadius, 0);
-                 x <= glm::min(chunkCoords.x + chunkRadius, chunkCount.x - 1);
-                 x++)
-            {
-                for (int y = glm::max(chunkCoords.y - chunkRadius, 0);
-                     y <= glm::min(chunkCoords.y + chunkRadius, chunkCount.y - 1);
-                     y++)
-                {
-                    auto* neighbourChunk = chunks[chunkCoordinatesToChunkIndex({x, y})];
-                    neighbourChunk->bShouldRebuildShadows = true;
+                    const auto getLightByte = [&cell](int index) {
+                        return (cell.light >> (index * 8)) & 0xFFU;
+                    };
+
+                    // same diagonal choice as getLight in Chunk.vs,
+                    // triangles are split along corners 0 and 2 of the emitted order
+                    const bool bShouldFlip =
+                        getLightByte(0) + getLightByte(3) > getLightByte(1) + getLightByte(2);
+                    const std::size_t firstCorner = bShouldFlip ? 0 : 1;
+
+                    auto normal = glm::vec3(0.F);
+                    normal[direction.normalAxis] = direction.normalSign;
+
+                    for (std::size_t i = 0; i < corners.size(); i++)
+                    {
+                        const auto& corner = corners[(firstCorner + i) % corners.size()];
+
+                        glm::vec3 position;
+                        position[direction.normalAxis] =
+                            chunkMin[direction.normalAxis] + static_cast<float>(slice) +
+                            (direction.normalSign > 0.F ? 1.F : 0.F);
+                        position[direction.uAxis] = chunkMin[direction.uAxis] +
+                                                    static_cast<float>(u + corner.x * width);
+                        position[direction.vAxis] = chunkMin[direction.vAxis] +
+                                                    static_cast<float>(v + corner.y * height);
+
+                        vertices.push_back(
+                            {position,
+                             normal,
+                             cell.id,
+                             static_cast<float>(getLightByte(corner.x + 2 * corner.y)) /
+                                 255.F});
+                    }
                 }
             }
         }
     }
+
+    return vertices;
 }
 
-VSChunkManager::VSChunk::VSVisibleBlockInfos VSChunkManager::chunkUpdateVisibility(
+std::vector<std::pair<std::size_t, std::uint8_t>> VSChunkManager::getVisibleBlockFaces(
     const std::atomic<bool>& bShouldCancel,
-    std::atomic<bool>& bIsReady,
-    std::size_t chunkIndex) const
+    std::size_t chunkIndex,
+    const VSChunkSnapshot& snapshot) const
 {
-    auto* const chunk = chunks[chunkIndex];
-
-    const auto chunkBlockCount = getChunkBlockCount();
-
-    auto result = VSChunkManager::VSChunk::VSVisibleBlockInfos();
+    if (!snapshot.paddedRows.empty())
+    {
+        return getVisibleBlockFacesFromOccupancy(chunkIndex, snapshot);
+    }
 
-    for (int blockIndex = 0; blockIndex < static_cast<int>(chunkBlockCount); blockIndex++)
+    // rows do not fit into a single word, check block by block
+    std::vector<std::pair<std::size_t, std::uint8_t>> visibleBlockFaces;
+    for (std::size_t blockIndex = 0; blockIndex < getChunkBlockCount(); blockIndex++)
     {
         if (bShouldCancel)
         {
             return {};
         }
 
-        if (chunk->blocks[blockIndex] != VS_DEFAULT_BLOCK_ID)
+        const auto blockCoordinates = blockIndexToBlockCoordinates(blockIndex);
+        if (!snapshot.isSectionHidden(blockCoordinates.y) &&
+            snapshot.blocks[snapshot.getIndex(blockCoordinates)] != VS_DEFAULT_BLOCK_ID)
         {
-            const auto blockType = isBlockVisible(chunkIndex, blockIndex);
+            const auto blockType = isBlockVisible(snapshot, chunkIndex, blockCoordinates);
             if (blockType != 0)
             {
-                const auto offset = chunk->chunkLocation +
-                                    glm::vec3(blockIndexToBlockCoordinates(blockIndex)) +
-                                    glm::vec3(0.5F) - glm::vec3(chunkSize) / 2.F;
-
-                const auto lighInfo = getLightInformation(offset);
-
-                const auto blockInfo = VSChunk::VSVisibleBlockInfo{
-                    offset,
-                    chunk->blocks[blockIndex],
-                    lighInfo[0],
-                    lighInfo[1],
-                    lighInfo[2],
-                    lighInfo[3],
-                    lighInfo[4],
-                    lighInfo[5]};
-                result[blockType].emplace_back(blockInfo);
-                chunk->bIsBlockVisible[blockIndex] = true;
-            }
-            else
-            {
-                chunk->bIsBlockVisible[blockIndex] = false;
+                visibleBlockFaces.emplace_back(blockIndex, blockType);
             }
         }
-        else
+    }
+    return visibleBlockFaces;
+}
+
+std::vector<std::pair<std::size_t, std::uint8_t>>
+VSChunkManager::getVisibleBlockFacesFromOccupancy(
+    std::size_t chunkIndex,
+    const VSChunkSnapshot& snapshot) const
+{
+    const auto width = chunkSize.x;
+    const auto height = chunkSize.y;
+    const auto depth = chunkSize.z;
+    const auto& paddedRows = snapshot.paddedRows;
+    const auto paddedStride = height + 2;
+
+    const auto chunkCoordinates = chunkIndexToChunkCoordinates(chunkIndex);
+
+    VSFaceMasks faceMasks;
+    faceMasks.compute(
+        paddedRows.data(),
+        snapshot.plusXEdges.data(),
+        snapshot.minusXEdges.data(),
+        height,
+        depth);
+
+    // world border blocks are visible from all sides if the block above is air
+    const std::uint64_t worldBorderColumns =
+        (chunkCoordinates.x == 0 ? 1ULL : 0ULL) |
+        (chunkCoordinates.x == chunkCount.x - 1 ? 1ULL << (width - 1) : 0ULL);
+
+    std::vector<std::pair<std::size_t, std::uint8_t>> visibleBlockFaces;
+
+    // only the lowest and highest layer of chunks have blocks at the bottom and top of the world
+    const bool bIsBottomChunk = chunkCoordinates.y == 0;
+    const bool bIsTopChunk = chunkCoordinates.y == chunkCount.y - 1;
+
+    for (int z = 0; z < depth; z++)
+    {
+        const bool bIsWorldBorderSlice = (z == 0 && chunkCoordinates.z == 0) ||
+                                         (z == depth - 1 && chunkCoordinates.z == chunkCount.z - 1);
+
+        for (int y = 0; y < height; y++)
         {
-            chunk->bIsBlockVisible[blockIndex] = false;
+            const auto row = static_cast<std::size_t>(y + z * height);
+            const auto occupied = paddedRows[(z + 1) * paddedStride + y + 1];
+            if (occupied == 0 || snapshot.isSectionHidden(y))
+            {
+                continue;
+            }
+
+            const bool bIsWorldTopRow = bIsTopChunk && y == height - 1;
+            const auto worldBorder =
+                (bIsWorldBorderSlice || (bIsBottomChunk && y == 0) || bIsWorldTopRow)
+                    ? ~0ULL
+                    : worldBorderColumns;
+
+            const auto right = faceMasks.right[row];
+            const auto left = faceMasks.left[row];
+            const auto top = faceMasks.top[row];
+            const auto bottom = faceMasks.bottom[row];
+            const auto front = faceMasks.front[row];
+            const auto back = faceMasks.back[row];
+
+            const auto visibleBorder = !bIsWorldTopRow ? occupied & worldBorder & top : 0ULL;
+            const auto visibleInner =
+                occupied & ~worldBorder & (right | left | top | bottom | front | back);
+
+            auto visible = visibleBorder | visibleInner;
+            while (visible != 0)
+            {
+                const auto x = VSFaceMasks::countTrailingZeros(visible);
+                visible &= visible - 1;
+
+                std::uint8_t encoded = 63;
+                if (((worldBorder >> x) & 1U) == 0)
+                {
+                    encoded = static_cast<std::uint8_t>(
+                        ((right >> x) & 1U) << VSCubeFace::Right |
+                        ((left >> x) & 1U) << VSCubeFace::Left |
+                        ((top >> x) & 1U) << VSCubeFace::Top |
+                        ((bottom >> x) & 1U) << VSCubeFace::Bottom |
+                        ((front >> x) & 1U) << VSCubeFace::Front |
+                        ((back >> x) & 1U) << VSCubeFace::Back);
+                }
+
+                visibleBlockFaces.emplace_back(row * width + x, encoded);
+            }
         }
     }
 
-    bIsReady = true;
-
-    return result;
-};
+    return visibleBlockFaces;
+}
 
-std::uint8_t VSChunkManager::isBlockVisible(std::size_t chunkIndex, std::size_t blockIndex) const
+void VSChunkManager::setOccupancy(
+    VSChunk::VSBlockData* blockData,
+    std::size_t blockIndex,
+    VSBlockID blockID) const
 {
-    const auto blockCoords = blockIndexToBlockCoordinates(blockIndex);
+    if (blockData->occupancy.empty())
+    {
+        return;
+    }
 
-    if (blockCoords.x == 0 || blockCoords.x == chunkSize.x - 1 || blockCoords.y == 0 ||
-        blockCoords.y == chunkSize.y - 1 || blockCoords.z == 0 || blockCoords.z == chunkSize.z - 1)
+    const auto row = blockIndex / chunkSize.x;
+    const auto bit = 1ULL << (blockIndex % chunkSize.x);
+    if (blockID != VS_DEFAULT_BLOCK_ID)
     {
-        return isBorderBlockVisible(chunkIndex, blockCoords);
+        blockData->occupancy[row] |= bit;
+    }
+    else
+    {
+        blockData->occupancy[row] &= ~bit;
     }
-    return isCenterBlockVisible(chunkIndex, blockCoords);
 }
 
-std::uint8_t VSChunkManager::isCenterBlockVisible(
-    std::size_t chunkIndex,
-    const glm::ivec3& blockCoordinates) const
+void VSChunkManager::rebuildOccupancy(VSChunk::VSBlockData* blockData) const
 {
-    const auto& blocks = chunks[chunkIndex]->blocks;
-
-    const auto right = glm::ivec3(blockCoordinates.x + 1, blockCoordinates.y, blockCoordinates.z);
-    const auto left = glm::ivec3(blockCoordinates.x - 1, blockCoordinates.y, blockCoordinates.z);
-
-    const auto top = glm::ivec3(blockCoordinates.x, blockCoordinates.y + 1, blockCoordinates.z);
-    const auto bottom = glm::ivec3(blockCoordinates.x, blockCoordinates.y - 1, blockCoordinates.z);
-
-    const auto front = glm::ivec3(blockCoordinates.x, blockCoordinates.y, blockCoordinates.z + 1);
-    // TODO is + 1 or -1 back?
-    const auto back = glm::ivec3(blockCoordinates.x, blockCoordinates.y, blockCoordinates.z - 1);
-
-    std::uint8_t encoded = 0;
-    encoded |= static_cast<int>(blocks[blockCoordinatesToBlockIndex(right)] == VS_DEFAULT_BLOCK_ID)
-               << VSCubeFace::Right;
-    encoded |= static_cast<int>(blocks[blockCoordinatesToBlockIndex(left)] == VS_DEFAULT_BLOCK_ID)
-               << VSCubeFace::Left;
-    encoded |= static_cast<int>(blocks[blockCoordinatesToBlockIndex(top)] == VS_DEFAULT_BLOCK_ID)
-               << VSCubeFace::Top;
-    encoded |= static_cast<int>(blocks[blockCoordinatesToBlockIndex(bottom)] == VS_DEFAULT_BLOCK_ID)
-               << VSCubeFace::Bottom;
-    encoded |= static_cast<int>(blocks[blockCoordinatesToBlockIndex(front)] == VS_DEFAULT_BLOCK_ID)
-               << VSCubeFace::Front;
-    encoded |= static_cast<int>(blocks[blockCoordinatesToBlockIndex(back)] == VS_DEFAULT_BLOCK_ID)
-               << VSCubeFace::Back;
-
-    return encoded;
+    std::fill(blockData->occupancy.begin(), blockData->occupancy.end(), 0);
+    for (std::size_t blockIndex = 0; blockIndex < getChunkBlockCount(); blockIndex++)
+    {
+        setOccupancy(blockData, blockIndex, blockData->sections.getBlock(blockIndex));
+    }
 }
 
-std::uint8_t VSChunkManager::isBorderBlockVisible(
+std::uint8_t VSChunkManager::isBlockVisible(
+    const VSChunkSnapshot& snapshot,
     std::size_t chunkIndex,
     const glm::ivec3& blockCoordinates) const
 {
+    const auto index = snapshot.getIndex(blockCoordinates);
+    const std::size_t strideY = snapshot.size.x;
+    const std::size_t strideZ = snapshot.size.x * snapshot.size.y;
+    const auto& blocks = snapshot.blocks;
+
     const auto blockWorldCoordinates =
         blockCoordinatesToWorldCoordinates(chunkIndex, blockCoordinates);
     if (isAtWorldBorder(blockWorldCoordinates))
     {
-        if (blockWorldCoordinates.y + 1 < worldSizeHalf.y &&
-            getBlock(blockWorldCoordinates + glm::ivec3(0, 1, 0)) == VS_DEFAULT_BLOCK_ID)
-        {
-            // always use a full block at the world border for now
-            return 63;
-        }
-        else
-        {
-            return 0;
-        }
+        // always use a full block at the world border for now
+        return blockWorldCoordinates.y + 1 < worldSizeHalf.y &&
+                       blocks[index + strideY] == VS_DEFAULT_BLOCK_ID
+                   ? 63
+                   : 0;
     }
 
-    const auto right = blockWorldCoordinates + glm::ivec3(1, 0, 0);
-
-    const auto left = blockWorldCoordinates + glm::ivec3(-1, 0, 0);
-
-    const auto top = blockWorldCoordinates + glm::ivec3(0, 1, 0);
-
-    const auto bottom = blockWorldCoordinates + glm::ivec3(0, -1, 0);
-
-    const auto front = blockWorldCoordinates + glm::ivec3(0, 0, 1);
-
-    // TODO is + 1 or -1 back?
-    const auto back = blockWorldCoordinates + glm::ivec3(0, 0, -1);
-
     std::uint8_t encoded = 0;
-    encoded |= static_cast<int>(getBlock(right) == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Right;
-    encoded |= static_cast<int>(getBlock(left) == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Left;
-    encoded |= static_cast<int>(getBlock(top) == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Top;
-    encoded |= static_cast<int>(getBlock(bottom) == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Bottom;
-    encoded |= static_cast<int>(getBlock(front) == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Front;
-    encoded |= static_cast<int>(getBlock(back) == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Back;
+    encoded |= static_cast<int>(blocks[index + 1] == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Right;
+    encoded |= static_cast<int>(blocks[index - 1] == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Left;
+    encoded |= static_cast<int>(blocks[index + strideY] == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Top;
+    encoded |= static_cast<int>(blocks[index - strideY] == VS_DEFAULT_BLOCK_ID)
+               << VSCubeFace::Bottom;
+    encoded |= static_cast<int>(blocks[index + strideZ] == VS_DEFAULT_BLOCK_ID)
+               << VSCubeFace::Front;
+    encoded |= static_cast<int>(blocks[index - strideZ] == VS_DEFAULT_BLOCK_ID) << VSCubeFace::Back;
 
     return encoded;
 }
@@ -1055,110 +3603,92 @@ bool VSChunkManager::isAtWorldBorder(const glm::ivec3& blockWorldCoordinates) co
            blockWorldCoordinates.z == worldSizeHalf.z - 1;
 }
 
-std::array<std::uint32_t, 6>
-VSChunkManager::getLightInformation(const glm::vec3& blockCoordinates) const
-{
-    std::array<std::uint32_t, 6> result;
-
-    const auto right = getLightInformationForFace(
-        blockCoordinates,
-        {glm::vec3{0.5F, -0.5F, -0.5F},
-         glm::vec3{0.5F, 0.5F, -0.5F},
-         glm::vec3{0.5F, -0.5F, 0.5F},
-         glm::vec3{0.5F, 0.5F, 0.5F}});
-    result[0] = right;
-
-    const auto left = getLightInformationForFace(
-        blockCoordinates,
-        {glm::vec3{-0.5F, -0.5F, -0.5F},
-         glm::vec3{-0.5F, 0.5F, -0.5F},
-         glm::vec3{-0.5F, -0.5F, 0.5F},
-         glm::vec3{-0.5F, 0.5F, 0.5F}});
-    result[1] = left;
-
-    const auto top = getLightInformationForFace(
-        blockCoordinates,
-        {glm::vec3{-0.5F, 0.5F, -0.5F},
-         glm::vec3{0.5F, 0.5F, -0.5F},
-         glm::vec3{-0.5F, 0.5F, 0.5F},
-         glm::vec3{0.5F, 0.5F, 0.5F}});
-    result[2] = top;
-
-    const auto bottom = getLightInformationForFace(
-        blockCoordinates,
-        {glm::vec3{-0.5F, -0.5F, -0.5F},
-         glm::vec3{0.5F, -0.5F, -0.5F},
-         glm::vec3{-0.5F, -0.5F, 0.5F},
-         glm::vec3{0.5F, -0.5F, 0.5F}});
-    result[3] = bottom;
-
-    const auto front = getLightInformationForFace(
-        blockCoordinates,
-        {glm::vec3{-0.5F, -0.5F, 0.5F},
-         glm::vec3{0.5F, -0.5F, 0.5F},
-         glm::vec3{-0.5F, 0.5F, 0.5F},
-         glm::vec3{0.5F, 0.5F, 0.5F}});
-    result[4] = front;
-
-    const auto back = getLightInformationForFace(
-        blockCoordinates,
-        {glm::vec3{-0.5F, -0.5F, -0.5F},
-         glm::vec3{0.5F, -0.5F, -0.5F},
-         glm::vec3{-0.5F, 0.5F, -0.5F},
-         glm::vec3{0.5F, 0.5F, -0.5F}});
-    result[5] = back;
-
-    return result;
-}
-
-std::uint32_t VSChunkManager::getLightInformationForFace(
-    const glm::vec3& blockWorldCoordinates,
-    const std::array<glm::vec3, 4>& corners) const
+std::array<std::uint32_t, 6> VSChunkManager::getLightInformation(
+    const VSChunkSnapshot& snapshot,
+    const glm::ivec3& blockCoordinates) const
 {
-    std::uint32_t result = 0;
-    int currentOffset = 0;
-    for (const auto& corner : corners)
+    // the apron outside of the world is air without light, so it adds nothing
+    const auto centerIndex = static_cast<std::ptrdiff_t>(snapshot.getIndex(blockCoordinates));
+    const std::ptrdiff_t strideY = snapshot.size.x;
+    const std::ptrdiff_t strideZ = snapshot.size.x * snapshot.size.y;
+
+    std::array<std::uint16_t, 27> samples;
+    std::size_t sample = 0;
+    for (std::ptrdiff_t z = -1; z <= 1; z++)
     {
-        const auto currentCorner = blockWorldCoordinates + corner;
-        float lightValue = 0;
-
-        for (const auto& sampleOffsets : corners)
+        for (std::ptrdiff_t y = -1; y <= 1; y++)
         {
-            const auto sample = currentCorner + sampleOffsets;
-            if (isLocationInBounds(sample))
+            for (std::ptrdiff_t x = -1; x <= 1; x++)
             {
-                // std::cout << glm::to_string(blockWorldCoordinates) << " " <<
-                // glm::to_string(sample)
-                //          << std::endl;
-
-                // TODO code dupe getBlock()
-                const auto zeroBaseLocation = glm::ivec3(glm::floor(sample)) + worldSizeHalf;
-                const auto [chunkIndex, blockIndex] =
-                    worldCoordinatesToChunkAndBlockIndex(zeroBaseLocation);
-                lightValue += chunks[chunkIndex]->blocks[blockIndex] != VS_DEFAULT_BLOCK_ID
-                                  ? 0.F
-                                  : chunks[chunkIndex]->lightLevel[blockIndex] + 8.F;
+                const auto sampleIndex = centerIndex + x + y * strideY + z * strideZ;
+                if (snapshot.blocks[sampleIndex] != VS_DEFAULT_BLOCK_ID)
+                {
+                    samples[sample++] = 0;
+                    continue;
+                }
+
+                const auto light = snapshot.light[sampleIndex];
+                samples[sample++] = getLightLevel(light, BlockLight) * blockLightSampleScale +
+                                    getLightLevel(light, SkyLight) * skyLightSampleScale;
             }
         }
-        lightValue /= corners.size();
+    }
+
+    return VSFaceLight::gather(samples);
+}
+
+std::uint32_t
+VSChunkManager::packLocation(std::size_t chunkIndex, const glm::ivec3& blockCoordinates) const
+{
+    return static_cast<std::uint32_t>(blockCoordinates.x) |
+           (static_cast<std::uint32_t>(blockCoordinates.y) << locationBitCounts.x) |
+           (static_cast<std::uint32_t>(blockCoordinates.z)
+            << (locationBitCounts.x + locationBitCounts.y)) |
+           (static_cast<std::uint32_t>(chunkIndex) << glm::compAdd(locationBitCounts));
+}
+
+glm::ivec3 VSChunkManager::unpackBlockCoordinates(std::uint32_t packedLocation) const
+{
+    const auto getBits = [packedLocation](std::uint32_t offset, std::uint32_t count) {
+        return static_cast<int>((packedLocation >> offset) & ((1U << count) - 1U));
+    };
 
-        std::uint8_t lightValueDeNorm = (glm::clamp(lightValue, 0.F, 32.F) / 32.F) * 255.F;
+    return {
+        getBits(0, locationBitCounts.x),
+        getBits(locationBitCounts.x, locationBitCounts.y),
+        getBits(locationBitCounts.x + locationBitCounts.y, locationBitCounts.z)};
+}
 
-        result |= (lightValueDeNorm << currentOffset);
+std::uint32_t
+VSChunkManager::packBlock(VSBlockID blockID, const std::array<std::uint32_t, 6>& light)
+{
+    std::uint32_t result = blockID;
+    for (std::size_t face = 0; face < light.size(); face++)
+    {
+        std::uint32_t lightSum = 0;
+        for (std::uint32_t corner = 0; corner < 4; corner++)
+        {
+            lightSum += (light[face] >> (corner * 8)) & 0xFFU;
+        }
 
-        currentOffset += 8;
+        // 4 corners of 8 bit down to 4 bit, rounded
+        const auto faceLight = (lightSum * 15 + 2 * 255) / (4 * 255);
+        result |= faceLight << (8 + face * 4);
     }
     return result;
 }
 
-std::size_t VSChunkManager::chunkCoordinatesToChunkIndex(const glm::ivec2& chunkCoordinates) const
+std::size_t VSChunkManager::chunkCoordinatesToChunkIndex(const glm::ivec3& chunkCoordinates) const
 {
-    return chunkCoordinates.y * chunkCount.x + chunkCoordinates.x;
+    return chunkCoordinates.x + chunkCoordinates.y * chunkCount.x +
+           static_cast<std::size_t>(chunkCoordinates.z) * chunkCount.x * chunkCount.y;
 }
 
-glm::ivec2 VSChunkManager::chunkIndexToChunkCoordinates(std::size_t chunkIndex) const
+glm::ivec3 VSChunkManager::chunkIndexToChunkCoordinates(std::size_t chunkIndex) const
 {
-    return {chunkIndex % chunkCount.y, chunkIndex / chunkCount.y};
+    const std::size_t countX = chunkCount.x;
+    const std::size_t countY = chunkCount.y;
+    return {chunkIndex % countX, (chunkIndex / countX) % countY, chunkIndex / (countX * countY)};
 }
 
 std::size_t VSChunkManager::blockCoordinatesToBlockIndex(const glm::ivec3& bloockCoords) const
@@ -1180,34 +3710,27 @@ glm::ivec3 VSChunkManager::blockIndexToBlockCoordinates(std::size_t blockIndex)
     return {x, y, z};
 }
 
-glm::ivec2 VSChunkManager::worldCoordinatesToChunkCoordinates(const glm::ivec3& worldCoords) const
+glm::ivec3 VSChunkManager::worldCoordinatesToChunkCoordinates(const glm::ivec3& worldCoords) const
 {
-    return {worldCoords.x / chunkSize.x, worldCoords.z / chunkSize.z};
+    return worldCoords / chunkSize;
 }
 
 std::tuple<std::size_t, std::size_t>
 VSChunkManager::worldCoordinatesToChunkAndBlockIndex(const glm::ivec3& worldCoords) const
 {
     const auto chunkCoordinates = worldCoordinatesToChunkCoordinates(worldCoords);
-    const auto chunkIndex = chunkCoordinatesToChunkIndex(chunkCoordinates);
     return {
-        chunkIndex,
-        blockCoordinatesToBlockIndex(
-            {worldCoords.x - chunkCoordinates.x * chunkSize.x,
-             worldCoords.y,
-             worldCoords.z - chunkCoordinates.y * chunkSize.z})};
+        chunkCoordinatesToChunkIndex(chunkCoordinates),
+        blockCoordinatesToBlockIndex(worldCoords - chunkCoordinates * chunkSize)};
 }
 
-std::tuple<glm::ivec2, std::size_t>
+std::tuple<glm::ivec3, std::size_t>
 VSChunkManager::worldCoordinatesToChunkCoordinatesAndBlockIndex(const glm::ivec3& worldCoords) const
 {
     const auto chunkCoordinates = worldCoordinatesToChunkCoordinates(worldCoords);
     return {
         chunkCoordinates,
-        blockCoordinatesToBlockIndex(
-            {worldCoords.x - chunkCoordinates.x * chunkSize.x,
-             worldCoords.y,
-             worldCoords.z - chunkCoordinates.y * chunkSize.z})};
+        blockCoordinatesToBlockIndex(worldCoords - chunkCoordinates * chunkSize)};
 }
 
 glm::ivec3 VSChunkManager::blockCoordinatesToWorldCoordinates(
@@ -1217,8 +3740,44 @@ glm::ivec3 VSChunkManager::blockCoordinatesToWorldCoordinates(
     return chunks[chunkIndex]->chunkLocation + glm::vec3(blockCoords - chunkSize / 2);
 }
 
-void VSChunkManager::setWorldData(const VSWorldData& worldData)
+VSChunkManager::VSWorldData VSChunkManager::createWorldData() const
+{
+    VSWorldData worldData{};
+    worldData.chunkSize = chunkSize;
+    worldData.chunkCount = chunkCount;
+    worldData.blocks.resize(getTotalBlockCount(), VS_DEFAULT_BLOCK_ID);
+    return worldData;
+}
+
+bool VSChunkManager::isWorldDataPending() const
+{
+    return bShouldInitializeFromData;
+}
+
+void VSChunkManager::setWorldData(VSWorldData worldData)
 {
-    worldDataFromFile = worldData;
+    std::lock_guard<std::mutex> lock(worldDataMutex);
+    worldDataFromFile = std::move(worldData);
     bShouldInitializeFromData = true;
 }
+
+void VSChunkManager::VSWorldData::setBlock(const glm::vec3& location, VSBlockID blockID)
+{
+    const auto worldSize = chunkSize * chunkCount;
+    const auto zeroBaseLocation = glm::ivec3(glm::floor(location)) + worldSize / 2;
+    if (glm::any(glm::lessThan(zeroBaseLocation, glm::ivec3(0))) ||
+        glm::any(glm::greaterThanEqual(zeroBaseLocation, worldSize)))
+    {
+        return;
+    }
+
+    const auto chunkCoordinates = zeroBaseLocation / chunkSize;
+    const auto blockCoordinates = zeroBaseLocation - chunkCoordinates * chunkSize;
+    const auto chunkIndex = static_cast<std::size_t>(
+        chunkCoordinates.x + chunkCoordinates.y * chunkCount.x +
+        chunkCoordinates.z * chunkCount.x * chunkCount.y);
+    const auto blockIndex = static_cast<std::size_t>(
+        blockCoordinates.x + blockCoordinates.y * chunkSize.x +
+        blockCoordinates.z * chunkSize.x * chunkSize.y);
+    blocks[chunkIndex * glm::compMul(chunkSize) + blockIndex] = blockID;
+}
@@ -0,0 +1,134 @@
+#include "world/vs_chunk_memory.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+#ifdef VS_CHUNK_HUGE_PAGES
+constexpr bool bShouldUseHugePages = true;
+#else
+constexpr bool bShouldUseHugePages = false;
+#endif
+
+std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+VSChunkMemory::VSChunkMemory()
+    : blockResource(bShouldUseHugePages),
+      pools(std::pmr::pool_options{0, largestPooledSize}, &blockResource)
+{
+}
+
+std::size_t VSChunkMemory::getReservedBytes() const
+{
+    return blockResource.getReservedBytes();
+}
+
+VSChunkMemory::VSBlockResource::VSBlockResource(bool bShouldUseHugePages)
+    : bShouldUseHugePages(bShouldUseHugePages)
+{
+}
+
+VSChunkMemory::VSBlockResource::~VSBlockResource()
+{
+    for (const auto& block : blocks)
+    {
+        freeBlock(block);
+    }
+}
+
+std::size_t VSChunkMemory::VSBlockResource::getReservedBytes() const
+{
+    std::lock_guard lock(mutex);
+    return reservedBytes;
+}
+
+void* VSChunkMemory::VSBlockResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    alignment = std::max(alignment, cacheLineSize);
+
+    // Whether an allocation shares a block only depends on its size, so do_deallocate can tell
+    // the two apart. Pool chunks are at most largestPooledSize, a quarter of a block.
+    if (bytes > largestPooledSize)
+    {
+        const auto block = allocateBlock(bytes, std::max(alignment, getBlockAlignment(bytes)));
+        std::lock_guard lock(mutex);
+        reservedBytes += block.size;
+        return block.data;
+    }
+
+    std::lock_guard lock(mutex);
+    if (!blocks.empty())
+    {
+        // the pools ask for chunks aligned to their size, more than the block is aligned to
+        const auto& block = blocks.back();
+        const auto address = reinterpret_cast<std::uintptr_t>(block.data);
+        const auto offset = alignUp(address + nextOffset, alignment) - address;
+        if (offset + bytes <= block.size)
+        {
+            nextOffset = offset + bytes;
+            return block.data + offset;
+        }
+    }
+
+    blocks.push_back(allocateBlock(blockSize, std::max(alignment, getBlockAlignment(blockSize))));
+    reservedBytes += blocks.back().size;
+    nextOffset = bytes;
+    return blocks.back().data;
+}
+
+void VSChunkMemory::VSBlockResource::do_deallocate(
+    void* pointer, std::size_t bytes, std::size_t alignment)
+{
+    // memory in the shared blocks goes back with the whole resource
+    if (bytes > largestPooledSize)
+    {
+        const auto blockAlignment =
+            std::max({alignment, cacheLineSize, getBlockAlignment(bytes)});
+        const auto block = VSBlock{
+            static_cast<std::byte*>(pointer), alignUp(bytes, blockAlignment), blockAlignment};
+        freeBlock(block);
+        std::lock_guard lock(mutex);
+        reservedBytes -= block.size;
+    }
+}
+
+bool VSChunkMemory::VSBlockResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+std::size_t VSChunkMemory::VSBlockResource::getBlockAlignment(std::size_t size) const
+{
+    return bShouldUseHugePages && size >= hugePageSize ? hugePageSize : cacheLineSize;
+}
+
+VSChunkMemory::VSBlockResource::VSBlock VSChunkMemory::VSBlockResource::allocateBlock(
+    std::size_t size, std::size_t alignment) const
+{
+    size = alignUp(size, alignment);
+    auto* data = static_cast<std::byte*>(::operator new(size, std::align_val_t(alignment)));
+#ifdef MADV_HUGEPAGE
+    if (alignment == hugePageSize)
+    {
+        // only a hint, without transparent huge pages the block keeps its regular pages
+        madvise(data, size, MADV_HUGEPAGE);
+    }
+#endif
+    return {data, size, alignment};
+}
+
+void VSChunkMemory::VSBlockResource::freeBlock(const VSBlock& block) const
+{
+    ::operator delete(block.data, block.size, std::align_val_t(block.alignment));
+}
@@ -0,0 +1,63 @@
+#include "world/vs_chunk_rebuild_queue.h"
+
+void VSChunkRebuildQueue::push(std::size_t chunkIndex)
+{
+    queuedSince.try_emplace(chunkIndex, VSClock::now());
+}
+
+void VSChunkRebuildQueue::prioritize(const VSPriorityFunction& getPriority)
+{
+    const auto now = VSClock::now();
+
+    std::vector<VSEntry> entries;
+    entries.reserve(queuedSince.size());
+    for (const auto& [chunkIndex, since] : queuedSince)
+    {
+        const auto waitSeconds = std::chrono::duration<float>(now - since).count();
+        entries.emplace_back(getPriority(chunkIndex, waitSeconds), chunkIndex);
+    }
+
+    order = decltype(order)(std::greater<>(), std::move(entries));
+}
+
+bool VSChunkRebuildQueue::pop(std::size_t& chunkIndex)
+{
+    while (!order.empty())
+    {
+        const auto entryChunkIndex = order.top().second;
+        order.pop();
+
+        // skip chunks that were already handed out
+        const auto queued = queuedSince.find(entryChunkIndex);
+        if (queued == queuedSince.end())
+        {
+            continue;
+        }
+
+        const auto waitSeconds = std::chrono::duration<float>(VSClock::now() - queued->second);
+        averageWaitSeconds += (waitSeconds.count() - averageWaitSeconds) * averageWaitWeight;
+
+        queuedSince.erase(queued);
+        chunkIndex = entryChunkIndex;
+        return true;
+    }
+
+    return false;
+}
+
+void VSChunkRebuildQueue::clear()
+{
+    queuedSince.clear();
+    order = {};
+    averageWaitSeconds = 0.F;
+}
+
+std::size_t VSChunkRebuildQueue::size() const
+{
+    return queuedSince.size();
+}
+
+float VSChunkRebuildQueue::getAverageWaitSeconds() const
+{
+    return averageWaitSeconds;
+}
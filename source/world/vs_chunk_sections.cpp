@@ -0,0 +1,237 @@
+#include "world/vs_chunk_sections.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+constexpr std::size_t lightValueCount = std::numeric_limits<std::uint8_t>::max() + 1;
+}
+
+template <typename BlockLayout>
+VSBasicChunkSections<BlockLayout>::VSBasicChunkSections(std::pmr::memory_resource* memory)
+    : sections(memory)
+{
+}
+
+template <typename BlockLayout>
+VSBasicChunkSections<BlockLayout>::VSBasicChunkSections(
+    const glm::ivec3& chunkSize,
+    std::uint8_t light,
+    std::pmr::memory_resource* memory)
+    : sections(memory)
+{
+    reset(chunkSize, light);
+}
+
+template <typename BlockLayout>
+VSBasicChunkSections<BlockLayout>::VSBasicChunkSections(const VSBasicChunkSections& other)
+    : sections(other.sections, other.sections.get_allocator()), size(other.size)
+{
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::reset(const glm::ivec3& chunkSize, std::uint8_t light)
+{
+    const auto sectionCount =
+        static_cast<std::size_t>((chunkSize.y + sectionHeight - 1) / sectionHeight);
+    if (chunkSize != size)
+    {
+        size = chunkSize;
+        sections.clear();
+        for (std::size_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex++)
+        {
+            sections.emplace_back(sections.get_allocator().resource());
+        }
+        // the height of the top section is only known once all sections exist
+        for (std::size_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex++)
+        {
+            sections[sectionIndex].layout = BlockLayout(
+                glm::ivec3(size.x, static_cast<int>(getSectionHeight(sectionIndex)), size.z));
+        }
+    }
+
+    for (std::size_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex++)
+    {
+        auto& section = sections[sectionIndex];
+        section.blocks.reset(
+            static_cast<std::size_t>(size.x) * getSectionHeight(sectionIndex) * size.z,
+            VS_DEFAULT_BLOCK_ID);
+        section.light.clear();
+        section.lightCounts.clear();
+        section.uniformLight = light;
+    }
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::setBlock(std::size_t blockIndex, VSBlockID blockID)
+{
+    const auto location = locate(blockIndex);
+    sections[location.sectionIndex].blocks.set(location.sectionBlockIndex, blockID);
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::setLight(std::size_t blockIndex, std::uint8_t light)
+{
+    const auto location = locate(blockIndex);
+    auto& section = sections[location.sectionIndex];
+    if (section.light.empty())
+    {
+        if (section.uniformLight == light)
+        {
+            return;
+        }
+        section.light.resize(section.blocks.size(), section.uniformLight);
+        section.lightCounts.resize(lightValueCount, 0);
+        section.lightCounts[section.uniformLight] =
+            static_cast<std::uint32_t>(section.light.size());
+    }
+
+    auto& blockLight = section.light[location.sectionBlockIndex];
+    section.lightCounts[blockLight]--;
+    section.lightCounts[light]++;
+    blockLight = light;
+
+    if (section.lightCounts[light] == section.light.size())
+    {
+        setSectionLight(location.sectionIndex, light);
+    }
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::setSectionLight(
+    std::size_t sectionIndex,
+    std::uint8_t light)
+{
+    auto& section = sections[sectionIndex];
+    section.light.clear();
+    section.light.shrink_to_fit();
+    section.lightCounts.clear();
+    section.lightCounts.shrink_to_fit();
+    section.uniformLight = light;
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::assignBlocks(const VSBlockID* source)
+{
+    const auto width = static_cast<std::size_t>(size.x);
+    const auto height = static_cast<std::size_t>(size.y);
+
+    std::vector<VSBlockID> sectionBlocks;
+    for (std::size_t sectionIndex = 0; sectionIndex < sections.size(); sectionIndex++)
+    {
+        const auto sectionRowCount = getSectionHeight(sectionIndex);
+        sectionBlocks.resize(sections[sectionIndex].blocks.size());
+
+        // rows of a section are spread over the whole chunk, one layer of z at a time
+        const auto& layout = sections[sectionIndex].layout;
+        for (std::size_t z = 0; z < static_cast<std::size_t>(size.z); z++)
+        {
+            const auto layer = source + (sectionIndex * sectionHeight + z * height) * width;
+            if constexpr (BlockLayout::bAreRowsContiguous)
+            {
+                const auto target = sectionBlocks.begin() + layout.getIndex(glm::ivec3(0, 0, z));
+                std::copy_n(layer, sectionRowCount * width, target);
+            }
+            else
+            {
+                for (std::size_t y = 0; y < sectionRowCount; y++)
+                {
+                    for (std::size_t x = 0; x < width; x++)
+                    {
+                        sectionBlocks[layout.getIndex(glm::ivec3(x, y, z))] = layer[y * width + x];
+                    }
+                }
+            }
+        }
+        sections[sectionIndex].blocks.assign(sectionBlocks.data());
+    }
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::copyRowBlocks(
+    std::size_t blockIndex,
+    std::size_t count,
+    VSBlockID* target) const
+{
+    const auto location = locate(blockIndex);
+    const auto& section = sections[location.sectionIndex];
+    if constexpr (BlockLayout::bAreRowsContiguous)
+    {
+        section.blocks.copyTo(location.sectionBlockIndex, count, target);
+    }
+    else
+    {
+        // copied a tile row at a time, those are contiguous
+        auto coordinates = location.sectionCoordinates;
+        for (std::size_t offset = 0; offset < count;)
+        {
+            const auto runLength = std::min(
+                count - offset,
+                static_cast<std::size_t>(section.layout.getRowRunLength(coordinates.x)));
+            section.blocks.copyTo(
+                section.layout.getIndex(coordinates), runLength, target + offset);
+            offset += runLength;
+            coordinates.x += static_cast<int>(runLength);
+        }
+    }
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::copyRowLight(
+    std::size_t blockIndex,
+    std::size_t count,
+    std::uint8_t* target) const
+{
+    const auto location = locate(blockIndex);
+    const auto& section = sections[location.sectionIndex];
+    if (section.light.empty())
+    {
+        std::fill_n(target, count, section.uniformLight);
+        return;
+    }
+    if constexpr (BlockLayout::bAreRowsContiguous)
+    {
+        std::copy_n(section.light.begin() + location.sectionBlockIndex, count, target);
+    }
+    else
+    {
+        auto coordinates = location.sectionCoordinates;
+        for (std::size_t offset = 0; offset < count;)
+        {
+            const auto runLength = std::min(
+                count - offset,
+                static_cast<std::size_t>(section.layout.getRowRunLength(coordinates.x)));
+            std::copy_n(
+                section.light.begin() + section.layout.getIndex(coordinates),
+                runLength,
+                target + offset);
+            offset += runLength;
+            coordinates.x += static_cast<int>(runLength);
+        }
+    }
+}
+
+template <typename BlockLayout>
+void VSBasicChunkSections<BlockLayout>::compact()
+{
+    for (auto& section : sections)
+    {
+        section.blocks.compact();
+    }
+}
+
+template <typename BlockLayout>
+std::size_t VSBasicChunkSections<BlockLayout>::getMemoryUsage() const
+{
+    std::size_t memoryUsage = sections.capacity() * sizeof(VSSection);
+    for (const auto& section : sections)
+    {
+        memoryUsage += section.blocks.getMemoryUsage() + section.light.capacity() +
+                       section.lightCounts.capacity() * sizeof(std::uint32_t);
+    }
+    return memoryUsage;
+}
+
+template class VSBasicChunkSections<VSLinearBlockLayout>;
+template class VSBasicChunkSections<VSTiledBlockLayout>;
@@ -0,0 +1,97 @@
+#include "world/vs_distance_transform.h"
+
+void VSDistanceTransform::compute(std::vector<float>& grid, const glm::ivec3& size)
+{
+    // squared distances are separable, one 1D pass per axis
+    for (int axis = 0; axis < 3; axis++)
+    {
+        transformAxis(grid, size, axis);
+    }
+}
+
+void VSDistanceTransform::transformAxis(
+    std::vector<float>& grid,
+    const glm::ivec3& size,
+    int axis)
+{
+    const glm::ivec3 strides = {1, size.x, size.x * size.y};
+    const auto count = size[axis];
+    const auto stride = static_cast<std::size_t>(strides[axis]);
+
+    // the two axes that are not transformed select the line
+    const auto outerAxis = axis == 2 ? 1 : 2;
+    const auto innerAxis = axis == 0 ? 1 : 0;
+
+    line.resize(count);
+    lineDistances.resize(count);
+    parabolaVertices.resize(count);
+    parabolaBounds.resize(count + 1);
+
+    for (int outer = 0; outer < size[outerAxis]; outer++)
+    {
+        for (int inner = 0; inner < size[innerAxis]; inner++)
+        {
+            const auto lineStart = static_cast<std::size_t>(outer) * strides[outerAxis] +
+                                   static_cast<std::size_t>(inner) * strides[innerAxis];
+
+            bool bHasFeature = false;
+            for (int i = 0; i < count; i++)
+            {
+                line[i] = grid[lineStart + i * stride];
+                bHasFeature |= line[i] < infinity;
+            }
+
+            // nothing to propagate along this line
+            if (!bHasFeature)
+            {
+                continue;
+            }
+
+            transformLine(count);
+
+            for (int i = 0; i < count; i++)
+            {
+                grid[lineStart + i * stride] = lineDistances[i];
+            }
+        }
+    }
+}
+
+void VSDistanceTransform::transformLine(int count)
+{
+    // lower envelope of the parabolas rooted at each cell
+    const auto intersection = [this](int q, int v) {
+        return ((line[q] + static_cast<float>(q * q)) - (line[v] + static_cast<float>(v * v))) /
+               static_cast<float>(2 * q - 2 * v);
+    };
+
+    int k = 0;
+    parabolaVertices[0] = 0;
+    parabolaBounds[0] = -infinity;
+    parabolaBounds[1] = infinity;
+
+    for (int q = 1; q < count; q++)
+    {
+        auto s = intersection(q, parabolaVertices[k]);
+        while (s <= parabolaBounds[k])
+        {
+            k--;
+            s = intersection(q, parabolaVertices[k]);
+        }
+        k++;
+        parabolaVertices[k] = q;
+        parabolaBounds[k] = s;
+        parabolaBounds[k + 1] = infinity;
+    }
+
+    k = 0;
+    for (int q = 0; q < count; q++)
+    {
+        while (parabolaBounds[k + 1] < static_cast<float>(q))
+        {
+            k++;
+        }
+        const auto offset = static_cast<float>(q - parabolaVertices[k]);
+        lineDistances[q] = offset * offset + line[parabolaVertices[k]];
+    }
+}
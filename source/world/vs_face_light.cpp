@@ -0,0 +1,84 @@
+#include "world/vs_face_light.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+std::array<std::uint32_t, 6> VSFaceLight::gather(const std::array<std::uint16_t, 27>& samples)
+{
+    struct VSFace
+    {
+        int normalAxis;
+        int uAxis;
+        int vAxis;
+        // sample layer along the normal axis
+        int layer;
+    };
+
+    static constexpr std::array<VSFace, 6> faces = {{
+        {0, 1, 2, 2},
+        {0, 1, 2, 0},
+        {1, 0, 2, 2},
+        {1, 0, 2, 0},
+        {2, 0, 1, 2},
+        {2, 0, 1, 0},
+    }};
+
+    static constexpr std::array<int, 3> strides = {1, 3, 9};
+
+    // each corner averages the 2x2 samples of the layer in front of the face it touches
+    alignas(16) std::array<std::uint16_t, 24> cornerSums{};
+    for (std::size_t face = 0; face < faces.size(); face++)
+    {
+        const auto& [normalAxis, uAxis, vAxis, layer] = faces[face];
+        const auto strideU = strides[uAxis];
+        const auto strideV = strides[vAxis];
+        for (int v = 0; v < 2; v++)
+        {
+            for (int u = 0; u < 2; u++)
+            {
+                const auto sample = layer * strides[normalAxis] + u * strideU + v * strideV;
+                cornerSums[face * 4 + u + 2 * v] = samples[sample] + samples[sample + strideU] +
+                                                   samples[sample + strideV] +
+                                                   samples[sample + strideU + strideV];
+            }
+        }
+    }
+
+    // clamp to full brightness and scale to 8 bit, 255 / maxCornerSampleSum is exactly 17 / 128
+    static_assert(maxCornerSampleSum * 17 == 255 * 128);
+    alignas(16) std::array<std::uint8_t, 32> cornerLights{};
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const auto maxSum = _mm_set1_epi16(maxCornerSampleSum);
+    const auto scale = _mm_set1_epi16(17);
+    const auto quantize = [&](std::size_t first) {
+        const auto sums = _mm_load_si128(reinterpret_cast<const __m128i*>(&cornerSums[first]));
+        return _mm_srli_epi16(_mm_mullo_epi16(_mm_min_epi16(sums, maxSum), scale), 7);
+    };
+    _mm_store_si128(
+        reinterpret_cast<__m128i*>(cornerLights.data()),
+        _mm_packus_epi16(quantize(0), quantize(8)));
+    _mm_store_si128(
+        reinterpret_cast<__m128i*>(cornerLights.data() + 16),
+        _mm_packus_epi16(quantize(16), _mm_setzero_si128()));
+#else
+    for (std::size_t corner = 0; corner < cornerSums.size(); corner++)
+    {
+        const auto sum = cornerSums[corner] < maxCornerSampleSum ? cornerSums[corner]
+                                                                  : maxCornerSampleSum;
+        cornerLights[corner] = static_cast<std::uint8_t>((sum * 17) >> 7);
+    }
+#endif
+
+    std::array<std::uint32_t, 6> result{};
+    for (std::size_t face = 0; face < result.size(); face++)
+    {
+        for (std::size_t corner = 0; corner < 4; corner++)
+        {
+            result[face] |= static_cast<std::uint32_t>(cornerLights[face * 4 + corner])
+                            << (corner * 8);
+        }
+    }
+    return result;
+}
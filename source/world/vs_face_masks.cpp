@@ -0,0 +1,109 @@
+#include "world/vs_face_masks.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+void VSFaceMasks::compute(
+    const std::uint64_t* paddedRows,
+    const std::uint64_t* plusXEdges,
+    const std::uint64_t* minusXEdges,
+    int rowCountY,
+    int rowCountZ)
+{
+    const auto rowCount = static_cast<std::size_t>(rowCountY) * rowCountZ;
+    for (auto* mask : {&right, &left, &top, &bottom, &front, &back})
+    {
+        mask->resize(rowCount);
+    }
+
+    const auto paddedStride = rowCountY + 2;
+
+    for (int z = 0; z < rowCountZ; z++)
+    {
+        // all rows of one z slice are stored back to back, neighbours along y and z are offsets
+        const auto* center = paddedRows + (z + 1) * paddedStride + 1;
+        const auto* plusEdge = plusXEdges + z * rowCountY;
+        const auto* minusEdge = minusXEdges + z * rowCountY;
+        const auto outOffset = static_cast<std::size_t>(z) * rowCountY;
+
+        int y = 0;
+
+#if defined(__AVX2__)
+        const auto allBits = _mm256_set1_epi64x(-1);
+        for (; y + 4 <= rowCountY; y += 4)
+        {
+            const auto load = [](const std::uint64_t* address) {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(address));
+            };
+            const auto store = [&allBits](std::vector<std::uint64_t>& mask, std::size_t index,
+                                          __m256i occupied) {
+                _mm256_storeu_si256(
+                    reinterpret_cast<__m256i*>(mask.data() + index),
+                    _mm256_andnot_si256(occupied, allBits));
+            };
+
+            const auto rows = load(center + y);
+            const auto index = outOffset + y;
+            store(right, index, _mm256_or_si256(_mm256_srli_epi64(rows, 1), load(plusEdge + y)));
+            store(left, index, _mm256_or_si256(_mm256_slli_epi64(rows, 1), load(minusEdge + y)));
+            store(top, index, load(center + y + 1));
+            store(bottom, index, load(center + y - 1));
+            store(front, index, load(center + y + paddedStride));
+            store(back, index, load(center + y - paddedStride));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        const auto allBits = _mm_set1_epi32(-1);
+        for (; y + 2 <= rowCountY; y += 2)
+        {
+            const auto load = [](const std::uint64_t* address) {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(address));
+            };
+            const auto store = [&allBits](std::vector<std::uint64_t>& mask, std::size_t index,
+                                          __m128i occupied) {
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(mask.data() + index),
+                    _mm_andnot_si128(occupied, allBits));
+            };
+
+            const auto rows = load(center + y);
+            const auto index = outOffset + y;
+            store(right, index, _mm_or_si128(_mm_srli_epi64(rows, 1), load(plusEdge + y)));
+            store(left, index, _mm_or_si128(_mm_slli_epi64(rows, 1), load(minusEdge + y)));
+            store(top, index, load(center + y + 1));
+            store(bottom, index, load(center + y - 1));
+            store(front, index, load(center + y + paddedStride));
+            store(back, index, load(center + y - paddedStride));
+        }
+#endif
+
+        for (; y < rowCountY; y++)
+        {
+            const auto rows = center[y];
+            const auto index = outOffset + y;
+            right[index] = ~((rows >> 1) | plusEdge[y]);
+            left[index] = ~((rows << 1) | minusEdge[y]);
+            top[index] = ~center[y + 1];
+            bottom[index] = ~center[y - 1];
+            front[index] = ~center[y + paddedStride];
+            back[index] = ~center[y - paddedStride];
+        }
+    }
+}
+
+int VSFaceMasks::countTrailingZeros(std::uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
@@ -0,0 +1,183 @@
+#include "world/vs_paletted_blocks.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace
+{
+constexpr std::size_t idCount = std::numeric_limits<VSBlockID>::max() + 1;
+
+std::uint8_t getBitsPerBlock(std::size_t paletteSize)
+{
+    std::uint8_t bitsPerBlock = 0;
+    while ((std::size_t{1} << bitsPerBlock) < paletteSize)
+    {
+        bitsPerBlock = bitsPerBlock == 0 ? 1 : bitsPerBlock * 2;
+    }
+    return bitsPerBlock;
+}
+}  // namespace
+
+VSPalettedBlocks::VSPalettedBlocks(std::pmr::memory_resource* memory)
+    : palette(memory), paletteCounts(memory), words(memory)
+{
+}
+
+VSPalettedBlocks::VSPalettedBlocks(
+    std::size_t blockCount,
+    VSBlockID blockID,
+    std::pmr::memory_resource* memory)
+    : VSPalettedBlocks(memory)
+{
+    reset(blockCount, blockID);
+}
+
+VSPalettedBlocks::VSPalettedBlocks(const VSPalettedBlocks& other)
+    : palette(other.palette, other.palette.get_allocator()),
+      paletteCounts(other.paletteCounts, other.paletteCounts.get_allocator()),
+      words(other.words, other.words.get_allocator()),
+      blockCount(other.blockCount),
+      bitsPerBlock(other.bitsPerBlock),
+      paletteIndexMask(other.paletteIndexMask)
+{
+}
+
+void VSPalettedBlocks::reset(std::size_t blockCountToSet, VSBlockID blockID)
+{
+    blockCount = blockCountToSet;
+    palette.assign(1, blockID);
+    paletteCounts.assign(1, static_cast<std::uint32_t>(blockCount));
+    bitsPerBlock = 0;
+    paletteIndexMask = 0;
+    words.assign(1, 0);
+}
+
+void VSPalettedBlocks::set(std::size_t blockIndex, VSBlockID blockID)
+{
+    if (get(blockIndex) == blockID)
+    {
+        return;
+    }
+
+    auto paletteIndex = static_cast<std::size_t>(
+        std::find(palette.begin(), palette.end(), blockID) - palette.begin());
+    if (paletteIndex == palette.size())
+    {
+        const auto unusedEntry = std::find(paletteCounts.begin(), paletteCounts.end(), 0U);
+        if (unusedEntry != paletteCounts.end())
+        {
+            paletteIndex = static_cast<std::size_t>(unusedEntry - paletteCounts.begin());
+            palette[paletteIndex] = blockID;
+        }
+        else
+        {
+            if (palette.size() > paletteIndexMask)
+            {
+                std::vector<VSBlockID> blocks(blockCount);
+                copyTo(0, blockCount, blocks.data());
+                pack(blocks.data(), 1);
+                paletteIndex = palette.size();
+            }
+            palette.push_back(blockID);
+            paletteCounts.push_back(0);
+        }
+    }
+
+    paletteCounts[getPaletteIndex(blockIndex)]--;
+    paletteCounts[paletteIndex]++;
+    setPaletteIndex(blockIndex, paletteIndex);
+
+    if (paletteCounts[paletteIndex] == blockCount)
+    {
+        palette.assign(1, blockID);
+        paletteCounts.assign(1, static_cast<std::uint32_t>(blockCount));
+        bitsPerBlock = 0;
+        paletteIndexMask = 0;
+        words.assign(1, 0);
+        words.shrink_to_fit();
+    }
+}
+
+void VSPalettedBlocks::assign(const VSBlockID* source)
+{
+    pack(source, 0);
+}
+
+void VSPalettedBlocks::copyTo(std::size_t blockIndex, std::size_t count, VSBlockID* target) const
+{
+    if (isUniform())
+    {
+        std::fill_n(target, count, palette.front());
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        target[i] = get(blockIndex + i);
+    }
+}
+
+void VSPalettedBlocks::compact()
+{
+    const auto usedCount = static_cast<std::size_t>(
+        paletteCounts.size() - std::count(paletteCounts.begin(), paletteCounts.end(), 0U));
+    if (getBitsPerBlock(usedCount) < bitsPerBlock)
+    {
+        std::vector<VSBlockID> blocks(blockCount);
+        copyTo(0, blockCount, blocks.data());
+        pack(blocks.data(), 0);
+    }
+}
+
+std::size_t VSPalettedBlocks::getMemoryUsage() const
+{
+    return palette.capacity() * sizeof(VSBlockID) +
+           paletteCounts.capacity() * sizeof(std::uint32_t) +
+           words.capacity() * sizeof(std::uint64_t);
+}
+
+void VSPalettedBlocks::pack(const VSBlockID* source, std::size_t reservedPaletteEntries)
+{
+    constexpr auto unusedID = std::numeric_limits<std::uint16_t>::max();
+    std::array<std::uint16_t, idCount> paletteIndices;
+    paletteIndices.fill(unusedID);
+
+    palette.clear();
+    paletteCounts.clear();
+    for (std::size_t blockIndex = 0; blockIndex < blockCount; blockIndex++)
+    {
+        const auto blockID = source[blockIndex];
+        if (paletteIndices[blockID] == unusedID)
+        {
+            paletteIndices[blockID] = static_cast<std::uint16_t>(palette.size());
+            palette.push_back(blockID);
+            paletteCounts.push_back(0);
+        }
+        paletteCounts[paletteIndices[blockID]]++;
+    }
+    if (palette.empty())
+    {
+        palette.push_back(VS_DEFAULT_BLOCK_ID);
+        paletteCounts.push_back(0);
+    }
+
+    bitsPerBlock = getBitsPerBlock(std::min(palette.size() + reservedPaletteEntries, idCount));
+    paletteIndexMask = (std::uint64_t{1} << bitsPerBlock) - 1;
+
+    // uniform blocks keep one word to read their index from
+    words.assign(std::max<std::size_t>((blockCount * bitsPerBlock + 63) / 64, 1), 0);
+    words.shrink_to_fit();
+    for (std::size_t blockIndex = 0; blockIndex < blockCount; blockIndex++)
+    {
+        setPaletteIndex(blockIndex, paletteIndices[source[blockIndex]]);
+    }
+}
+
+void VSPalettedBlocks::setPaletteIndex(std::size_t blockIndex, std::uint64_t paletteIndex)
+{
+    const auto bitIndex = blockIndex * bitsPerBlock;
+    const auto shift = bitIndex % 64;
+    auto& word = words[bitIndex / 64];
+    word = (word & ~(paletteIndexMask << shift)) | (paletteIndex << shift);
+}